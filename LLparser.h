@@ -15,6 +15,7 @@
 #include <vector>
 #include <set>
 #include <deque>
+#include <cstdint>
 using namespace std;
 ///Ҫ޸׼뺯
 void read_prog(string &prog) {
@@ -28,7 +29,7 @@ void read_prog(string &prog) {
 ///
 
 ///tokenӦö
-enum { UNEXPECTED_SYMBOL,EARLY_EOF };
+enum { UNEXPECTED_SYMBOL,EARLY_EOF,SKIPPED_SYMBOL };
 /**
  * tokenṹ壬Ҫʹַк.
  */
@@ -54,6 +55,70 @@ struct error {
 		type = t; word = w; line_num = ln;
 	}
 };
+/**
+ * ﷨㣬нLLparsernodesУ±껥ã
+ * һӽnodesһ[first, first+cnt).
+ */
+struct node {
+	uint16_t sym;	///Generator::sidеı
+	bool visited;	///ǷѾջδջĽ㲻ӡ
+	int first;	///һӽ±꣬սΪƥ䵽token±꣬ûʱΪ-1
+	int cnt;	///ӽ
+
+	node() {}
+	node(int s) {
+		sym = s; first = -1; cnt = 0; visited = false;
+	}
+};
+/**
+ * ŵıƽ﷨ĸ鰴±룬ָ룬
+ * iռ[i - size[i] + 1, i]һi - 1
+ * ǰһֵc - size[c]ÿ14ֽڣֱӰֽдļ.
+ */
+struct flat_tree {
+	vector<uint16_t> kind;	///ű
+	vector<int> tok;	///սӦtoken±꣬ûʱΪ-1
+	vector<int> first;	///һӵ±꣬ҶΪ-1
+	vector<int> size;	///ĽԼ
+
+	int count() const { return kind.size(); }
+	int add(int k, int t, int f, int s) {
+		kind.push_back(k); tok.push_back(t); first.push_back(f); size.push_back(s);
+		return kind.size() - 1;
+	}
+	void save(ostream& out) const;
+	bool load(istream& in);
+};
+/**
+ * ддĸԭʼֽ.
+ * 
+ * \param out
+ */
+void flat_tree::save(ostream& out) const {
+	int n = count();
+	out.write((const char*)&n, sizeof(n));
+	out.write((const char*)kind.data(), n * sizeof(uint16_t));
+	out.write((const char*)tok.data(), n * sizeof(int));
+	out.write((const char*)first.data(), n * sizeof(int));
+	out.write((const char*)size.data(), n * sizeof(int));
+}
+/**
+ * saveдݣʧʱfalse.
+ * 
+ * \param in
+ * \return 
+ */
+bool flat_tree::load(istream& in) {
+	int n = 0;
+	if (!in.read((char*)&n, sizeof(n)) || n < 0)
+		return false;
+	kind.resize(n); tok.resize(n); first.resize(n); size.resize(n);
+	in.read((char*)kind.data(), n * sizeof(uint16_t));
+	in.read((char*)tok.data(), n * sizeof(int));
+	in.read((char*)first.data(), n * sizeof(int));
+	in.read((char*)size.data(), n * sizeof(int));
+	return (bool)in;
+}
 
 vector<token> split_word(string s);
 /**
@@ -87,6 +152,9 @@ bool ErrorHandler::report() {
 			case EARLY_EOF:
 				cout << "ﲻӦEOF,Ĵ벻,"<<endl;
 				break;
+			case SKIPPED_SYMBOL:
+				cout << "\"" << e.word << "\"" << endl;
+				break;
 			default:
 				cout << "unkown error" << endl;
 			}
@@ -109,12 +177,23 @@ public:
 	vector< set<string>> follow;
 	vector< vector<int>> table;
 	map<string, int> sid;
+	int ncol;
+	vector<int16_t> dense;
+	vector<char> is_term;
+	vector<char> nullable_id;
+	vector<int> null_pid_id;	///űŵnull_pidûпղʽʱΪ-1
+	int eps;	///Eķű
+	vector<char> starts;
+	vector<char> sync;
+	vector< vector<uint16_t>> rhs;
 	Generator();
 	Generator(string raw_rules);
 	void generate_dic();
 	void generate_first();
 	void generate_follow();
 	void generate_LLtable();
+	void generate_dense();
+	string generate_RDparser(int max_insert, int max_skip);
 };
 
 Generator::Generator() {}
@@ -278,21 +357,581 @@ void Generator::generate_LLtable() {
 	generate_dic();
 	generate_first();
 	generate_follow();
+	generate_dense();
+}
+/**
+ * LL(1) tableͲʽתֻ÷űŵĽʽLLparser::executeʹã
+ * dense[sym * ncol + tok]ΪʽidһвӦκηţʶtoken
+ * rhsΪʽҲķűţղʽҲΪգ
+ * null_pid_ideps÷ʱֲٰҿղʽE.
+ * 
+ */
+void Generator::generate_dense() {
+	ncol = table[0].size();
+	dense.assign(table.size() * ncol, -1);
+	for (int i = 0; i < table.size(); i++)
+		for (int j = 0; j < ncol; j++)
+			dense[i * ncol + j] = table[i][j];
+	is_term.assign(ncol, 0);
+	nullable_id.assign(ncol, 0);
+	for (auto t : term)
+		is_term[sid[t]] = 1;
+	null_pid_id.assign(ncol, -1);
+	for (auto nt : nonterm) {
+		nullable_id[sid[nt]] = nullable[nt];
+		if (null_pid.count(nt))
+			null_pid_id[sid[nt]] = null_pid[nt];
+	}
+	eps = sid["E"];
+	///starts[sym * ncol + tok]ʾtoksymfirst
+	///sync[sym * ncol + tok]ʾtoksymͬfollow$
+	starts.assign(ncol * ncol, 0);
+	sync.assign(ncol * ncol, 0);
+	for (auto t : term)
+		starts[sid[t] * ncol + sid[t]] = 1;
+	for (auto nt : nonterm) {
+		int a = sid[nt];
+		for (auto f : first[a])
+			starts[a * ncol + sid[f]] = 1;
+		for (auto f : follow[a])
+			sync[a * ncol + sid[f]] = 1;
+		sync[a * ncol + sid["$"]] = 1;
+	}
+	rhs.clear();
+	for (auto ps : productions) {
+		vector<uint16_t> r;
+		for (int i = 1; i < ps.size(); i++) {
+			if (ps[i] != "E")
+				r.push_back(sid[ps[i]]);
+		}
+		rhs.push_back(r);
+	}
+}
+/**
+ * ѷתɿԷC++ַеʽ.
+ * 
+ * \param s
+ * \return 
+ */
+string c_literal(string s) {
+	string res = "\"";
+	for (auto c : s) {
+		if (c == '"' || c == '\\')
+			res += '\\';
+		res += c;
+	}
+	return res + "\"";
+}
+/**
+ * ѷսתɺϷC++ʶ.
+ * 
+ * \param s
+ * \return 
+ */
+string c_ident(string s) {
+	string res = "p_";
+	for (auto c : s) {
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_')
+			res += c;
+		else
+			res += '_';
+	}
+	return res;
+}
+/**
+ * LL(1) tableֱӱĵݹ½Դ룬
+ * ÿսһswitchtokenѡʽ
+ * ɵԴͱļһṩread_progAnalysisLLparserͬ.
+ * ɵĴstk¼ûзķţLLparser::executeworkջһ£
+ * ͬstartssyncȱһдԴ룬ʱexecuteͬ˳սƳE
+ * token·ԴϢҲͬ.
+ * ʽұβݹдѭⳤеĵݹ.
+ * 
+ * \param max_insert ϵս
+ * \param max_skip ÿγtoken
+ * \return 
+ */
+string Generator::generate_RDparser(int max_insert, int max_skip) {
+	ostringstream os;
+	os << R"RD(// LLparser::emit_RDparserLL(1) tableԶɣҪֶ޸
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+/* Ҫ޸׼뺯 */
+void read_prog(string& prog) {
+	char c;
+	while (scanf("%c", &c) != EOF) {
+		if (c == '#')
+			break;
+		prog += c;
+	}
+}
+
+enum { UNEXPECTED_SYMBOL, EARLY_EOF, SKIPPED_SYMBOL };
+struct error {
+	int type;
+	string word;
+	int line_num;
+	error(int t, string w, int ln) {
+		type = t; word = w; line_num = ln;
+	}
+};
+static vector<int> tok;
+static vector<int> tline;
+static vector<string> word;	///tokenԭģtokenʱʹ
+static vector<int> stk;	///ûзķţLLparser::executeworkջͬ
+static int pos = 0, curline = 1, inserted = 0;
+static bool eof_hit = false;
+static string out;
+static vector<error> errors;
+
+static void emit(const char* name, int d) {
+	out.append(d, '\t');
+	out += name;
+	out += '\n';
+}
+static bool at_end() {
+	if (pos < tok.size())
+		return false;
+	eof_hit = true;
+	return true;
+}
+)RD";
+	///űŵıgenerate_denseõͬ'1'ʾ
+	auto bits = [&](const vector<char>& v, int from) {
+		string res = "\"";
+		for (int j = 0; j < ncol; j++)
+			res += v[from + j] ? '1' : '0';
+		return res + "\"";
+	};
+	os << "static const int UNKNOWN = " << ncol - 1 << ";\n";
+	os << "static const int max_insert = " << max_insert << ", max_skip = " << max_skip << ";\n";
+	os << "static const char* is_term = " << bits(is_term, 0) << ";\n";
+	os << "static const char* nullable_id = " << bits(nullable_id, 0) << ";\n";
+	os << "static const char* starts[] = {\n";
+	for (int i = 0; i < ncol; i++)
+		os << "\t" << bits(starts, i * ncol) << ",\n";
+	os << "};\n";
+	os << "static const char* sync_set[] = {\n";
+	for (int i = 0; i < ncol; i++)
+		os << "\t" << bits(sync, i * ncol) << ",\n";
+	os << "};\n";
+	os << R"RD(
+/**
+ * LLparser::can_followͬstkпΪյķսһΪյķܷlookʼ.
+ */
+static bool can_follow(int look) {
+	for (int i = (int)stk.size() - 1; i >= 0; i--) {
+		int sym = stk[i];
+		if (starts[sym][look] == '1')
+			return true;
+		if (is_term[sym] == '1' || nullable_id[sym] == '0')
+			return false;
+	}
+	return false;
+}
+/**
+ * LLparser::wantedֻͬstkϵ64.
+ */
+static bool wanted(int look) {
+	for (int i = (int)stk.size() - 1; i >= 0 && i >= (int)stk.size() - 64; i--) {
+		if (starts[stk[i]][look] == '1' || sync_set[stk[i]][look] == '1')
+			return true;
+	}
+	return false;
+}
+/**
+ * panic modeܿʼsymҲͬеtokenmax_skip
+ * ܷ·sym.
+ */
+static bool panic(int sym) {
+	int skipped = 0;
+	while (pos < tok.size() && starts[sym][tok[pos]] != '1' && skipped < max_skip &&
+		!(is_term[sym] == '1' ? can_follow(tok[pos]) : sync_set[sym][tok[pos]] == '1')) {
+		errors.push_back(error(SKIPPED_SYMBOL, word[pos], tline[pos]));
+		curline = tline[pos];
+		pos++;
+		skipped++;
+	}
+	return pos < tok.size() && starts[sym][tok[pos]] == '1';
+}
+static void match(int t, const char* name, int d) {
+	if (at_end())
+		return;
+	emit(name, d);
+	for (;;) {
+		if (tok[pos] == t) {
+			curline = tline[pos];
+			pos++;
+			inserted = 0;
+			return;
+		}
+		///ϺܼΪѾƥ䣬
+		if (inserted < max_insert && can_follow(tok[pos])) {
+			errors.push_back(error(UNEXPECTED_SYMBOL, name, curline));
+			inserted++;
+			return;
+		}
+		if (!panic(t)) {
+			errors.push_back(error(UNEXPECTED_SYMBOL, name, curline));
+			return;
+		}
+	}
+}
+)RD";
+	os << "static map<string, int> tid = {";
+	bool first_tid = true;
+	for (auto t : term) {
+		if (t == "E" || t == "$")
+			continue;
+		os << (first_tid ? "" : ",") << "{" << c_literal(t) << "," << sid[t] << "}";
+		first_tid = false;
+	}
+	os << "};\n\n";
+	for (auto nt : nonterm)
+		os << "static void " << c_ident(nt) << "(int d);\n";
+	os << "\n";
+	for (auto nt : nonterm) {
+		int row = sid[nt];
+		///ʽ飬ͬһʽtokenŹһδ
+		map<int, vector<int>> cases;
+		for (auto t : term) {
+			if (t == "E")
+				continue;
+			int pid = table[row][sid[t]];
+			if (pid != -1)
+				cases[pid].push_back(sid[t]);
+		}
+		bool tail = false;
+		for (auto it : cases) {
+			vector<string>& p = productions[it.first];
+			if (p.size() > 2 && p.back() == nt)
+				tail = true;
+		}
+		os << "static void " << c_ident(nt) << "(int d) {\n";
+		string ind = "\t";
+		if (tail) {
+			os << "\tfor (;;) {\n";
+			ind = "\t\t";
+		}
+		os << ind << "if (at_end())\n" << ind << "\treturn;\n";
+		os << ind << "emit(" << c_literal(nt) << ", d);\n";
+		os << ind.substr(1) << "retry:\n";
+		os << ind << "switch (tok[pos]) {\n";
+		for (auto it : cases) {
+			vector<string>& p = productions[it.first];
+			for (auto t : it.second) {
+				string name;
+				for (auto ts : term)
+					if (sid[ts] == t)
+						name = ts;
+				os << ind << "case " << t << ": /* " << name << " */\n";
+			}
+			if (p.size() == 2 && p[1] == "E") {
+				os << ind << "\temit(\"E\", d + 1);\n" << ind << "\treturn;\n";
+				continue;
+			}
+			///Ҳѹstkÿ֮ǰ
+			os << ind << "\tstk.insert(stk.end(), {";
+			for (int i = p.size() - 1; i >= 1; i--)
+				os << sid[p[i]] << (i > 1 ? ", " : "");
+			os << "});\n";
+			for (int i = 1; i < p.size(); i++) {
+				os << ind << "\tstk.pop_back();\n";
+				if (i == p.size() - 1 && tail && p[i] == nt) {
+					os << ind << "\td++;\n" << ind << "\tcontinue;\n";
+					break;
+				}
+				if (nonterm.count(p[i]))
+					os << ind << "\t" << c_ident(p[i]) << "(d + 1);\n";
+				else
+					os << ind << "\tmatch(" << sid[p[i]] << ", " << c_literal(p[i]) << ", d + 1);\n";
+				if (i == p.size() - 1)
+					os << ind << "\treturn;\n";
+			}
+		}
+		os << ind << "}\n";
+		///ָ˳LLparser::executeͬ
+		if (nullable[nt])
+			os << ind << "if (wanted(tok[pos])) {\n" << ind << "\temit(\"E\", d + 1);\n" << ind << "\treturn;\n" << ind << "}\n";
+		os << ind << "if (panic(" << row << "))\n" << ind << "\tgoto retry;\n";
+		if (nullable[nt])
+			os << ind << "emit(\"E\", d + 1);\n";
+		else
+			os << ind << "errors.push_back(error(UNEXPECTED_SYMBOL, " << c_literal(nt) << ", curline));\n";
+		os << ind << "return;\n";
+		if (tail)
+			os << "\t}\n";
+		os << "}\n\n";
+	}
+	os << R"RD(/**
+ * ʷLLparserеLexAnalyzerֱͬӵõtokenţʶĴʱΪUNKNOWN.
+ */
+static bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+static bool is_alpha(char c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+static void lex(string s) {
+	int ln = 1;
+	for (int i = 0; i < s.size(); i++) {
+		char c = s[i];
+		if (c == '\n') {
+			ln++;
+			continue;
+		}
+		if (c == ' ' || c == '\t' || c == '\r')
+			continue;
+		string text(1, c);
+		string key;	///tidõս
+		if (is_digit(c)) {
+			bool dot = false;
+			while (i + 1 < s.size() && (is_digit(s[i + 1]) || (s[i + 1] == '.' && !dot))) {
+				dot = dot || s[i + 1] == '.';
+				text += s[++i];
+			}
+			key = "NUM";
+		}
+		else if (is_alpha(c)) {
+			while (i + 1 < s.size() && (is_digit(s[i + 1]) || is_alpha(s[i + 1])))
+				text += s[++i];
+			key = tid.count(text) ? text : "ID";
+		}
+		else if (c == '/' && i + 1 < s.size() && s[i + 1] == '/') {
+			while (i + 1 < s.size() && s[i + 1] != '\n')
+				i++;
+			continue;
+		}
+		else if (c == '/' && i + 1 < s.size() && s[i + 1] == '*') {
+			i += 2;
+			while (i + 1 < s.size() && !(s[i] == '*' && s[i + 1] == '/')) {
+				if (s[i] == '\n')
+					ln++;
+				i++;
+			}
+			i++;
+			continue;
+		}
+		else if (i + 1 < s.size() && tid.count(s.substr(i, 2)))
+			text += s[++i];
+		if (key.empty())
+			key = text;
+		auto it = tid.find(key);
+		tok.push_back(it == tid.end() ? UNKNOWN : it->second);
+		tline.push_back(ln);
+		word.push_back(text);
+	}
+}
+
+void Analysis() {
+	string prog;
+	read_prog(prog);
+	lex(prog);
+)RD";
+	os << "\t" << c_ident(productions[0][0]) << "(0);\n";
+	os << R"RD(	if (eof_hit)
+		errors.push_back(error(EARLY_EOF, "", curline));
+	else if (pos < tok.size())
+		errors.push_back(error(SKIPPED_SYMBOL, word[pos], tline[pos]));
+	for (auto e : errors) {
+		cout << "﷨," << e.line_num << ",";
+		if (e.type == UNEXPECTED_SYMBOL)
+			cout << "ȱ\"" << e.word << "\"" << endl;
+		else if (e.type == SKIPPED_SYMBOL)
+			cout << "\"" << e.word << "\"" << endl;
+		else
+			cout << "ﲻӦEOF,Ĵ벻," << endl;
+	}
+	cout << out;
+}
+)RD";
+	return os.str();
+}
+
+/**
+ * жַ͵ĺLexicalAnalysis.hͬ.
+ * 
+ * \param c
+ * \return 
+ */
+bool isDigit(char c) {
+	if (c >= '0' && c <= '9')
+		return true;
+	return false;
+}
+bool isAlpha(char c) {
+	if (c >= 'a' && c <= 'z')
+		return true;
+	if (c >= 'A' && c <= 'Z')
+		return true;
+	if (c == '_')
+		return true;
+	return false;
+}
+/**
+ * ʷLexicalAnalysis.hеLexAnalyzerд
+ * ֱɨԴõкŵtokenҪȰСոз֣
+ * ͨtidķеսӳɷűţ
+ * սıʶΪIDּΪNUM಻ʶĴʱΪunknown.
+ */
+class LexAnalyzer {
+public:
+	string input;
+	map<string, int> tid;
+	int unknown;
+	int line;
+	vector<token> res;
+	LexAnalyzer(Generator& g);
+	void execute(string input);
+	void add(string word, string sym);
+	int get_num(int pos, string word);
+	int get_operator(int pos, string word);
+	int get_alpha(int pos, string word);
+};
+/**
+ * ķսʼid.
+ * 
+ * \param g
+ */
+LexAnalyzer::LexAnalyzer(Generator& g) {
+	for (auto t : g.term) {
+		if (t != "E" && t != "$")
+			tid[t] = g.sid[t];
+	}
+	unknown = g.ncol - 1;
+	line = 1;
+}
+/**
+ * ¼һtokenwordΪԭģsymΪӦս
+ * tokentypeΪսı.
+ * 
+ * \param word
+ * \param sym
+ */
+void LexAnalyzer::add(string word, string sym) {
+	auto it = tid.find(sym);
+	res.push_back(token(word, -1, it == tid.end() ? unknown : it->second, line));
+}
+/**
+ * ֣tokenһַλ.
+ * 
+ * \param pos
+ * \param word
+ * \return 
+ */
+int LexAnalyzer::get_num(int pos, string word) {
+	int j = pos;
+	int state = 0;
+	while (j + 1 < input.length()) {
+		j++;
+		if (isDigit(input[j]))
+			;
+		else if (input[j] == '.' && state == 0)
+			state = 1;
+		else
+			break;
+		word += input[j];
+	}
+	add(word, "NUM");
+	return pos + word.length() - 1;
+}
+/**
+ * ͽַսʱȡģ
+ * עͣtokenһַλ.
+ * 
+ * \param pos
+ * \param word
+ * \return 
+ */
+int LexAnalyzer::get_operator(int pos, string word) {
+	int i = pos;
+	if (i + 1 < input.length()) {
+		if (input[i] == '/' && input[i + 1] == '/') {
+			while (i + 1 < input.length() && input[i + 1] != '\n')
+				i++;
+			return i;
+		}
+		if (input[i] == '/' && input[i + 1] == '*') {
+			i += 2;
+			while (i + 1 < input.length() && !(input[i] == '*' && input[i + 1] == '/')) {
+				if (input[i] == '\n')
+					line++;
+				i++;
+			}
+			return i + 1;
+		}
+		if (tid.count(input.substr(i, 2)))
+			word += input[i + 1];
+	}
+	add(word, word);
+	return pos + word.length() - 1;
+}
+/**
+ * ܹؼֻ߱ʶtokenһַλ.
+ * 
+ * \param pos
+ * \param word
+ * \return 
+ */
+int LexAnalyzer::get_alpha(int pos, string word) {
+	int j = pos;
+	while (j + 1 < input.length() && (isDigit(input[j + 1]) || isAlpha(input[j + 1]))) {
+		j++;
+		word += input[j];
+	}
+	add(word, tid.count(word) ? word : "ID");
+	return pos + word.length() - 1;
+}
+/**
+ * ɨ룬ַѡtokenķʽ.
+ * 
+ * \param raw_input
+ */
+void LexAnalyzer::execute(string raw_input) {
+	input = raw_input;
+	res.clear();
+	res.reserve(input.length() / 2 + 1);
+	for (int i = 0; i < input.length(); i++) {
+		char c = input[i];
+		if (c == '\n')
+			line++;
+		else if (c == ' ' || c == '\t' || c == '\r')
+			;
+		else if (isDigit(c))
+			i = get_num(i, string(1, c));
+		else if (isAlpha(c))
+			i = get_alpha(i, string(1, c));
+		else
+			i = get_operator(i, string(1, c));
+	}
 }
 
 class LLparser {
 private:
-	deque<token> input;
-	deque<token> work;
-	deque<int> depth;
+	vector<uint16_t> input;
+	vector<int> input_line;
+	vector<uint32_t> work;
+	vector<node> nodes;
+	vector<string> sym_name;
 	string parse_res;
-	vector<token> tokens;
 	ErrorHandler e;
 	Generator g;
+	int max_insert = 3;
+	int max_skip = 8;
 public:
 	LLparser();
 	void init_table(string rules);
 	void execute(string input);
+	void add_children(int parent, int pid);
+	bool can_follow(int look);
+	bool wanted(int look);
+	void render();
+	flat_tree to_flat();
+	void emit_RDparser(string path);
 };
 
 LLparser::LLparser() {}
@@ -301,10 +940,153 @@ void LLparser::init_table(string raw_rules) {
 	
 	g = Generator(raw_rules);
 	g.generate_LLtable();
+	sym_name.resize(g.sid.size());
+	for (auto it : g.sid)
+		sym_name[it.second] = it.first;
 
 }
 /**
- * ִʺԭʼָɴкϢtoken.
+ * LL(1) tableɵĵݹ½Դдpath.
+ * 
+ * \param path
+ */
+void LLparser::emit_RDparser(string path) {
+	ofstream fout(path.c_str());
+	fout << g.generate_RDparser(max_insert, max_skip);
+}
+/**
+ * arenaĩβΪparentһӽ㣬ӽ㰴ѹworkջ
+ * ղʽֻһѷʵE.
+ * execute볤ԤֻǹƣָʱչĴûޣ
+ * ʱɱÿչһ.
+ * 
+ * \param parent
+ * \param pid ʽid
+ */
+void LLparser::add_children(int parent, int pid) {
+	int first = nodes.size();
+	vector<uint16_t>& r = g.rhs[pid];
+	if (nodes.size() + r.size() + 1 > nodes.capacity())
+		nodes.reserve(2 * nodes.capacity() + r.size() + 1);
+	if (work.size() + r.size() > work.capacity())
+		work.reserve(2 * work.capacity() + r.size());
+	nodes[parent].first = first;
+	if (r.empty()) {
+		nodes.push_back(node(g.eps));
+		nodes.back().visited = true;
+		nodes[parent].cnt = 1;
+		return;
+	}
+	for (int i = 0; i < r.size(); i++)
+		nodes.push_back(node(r[i]));
+	nodes[parent].cnt = r.size();
+	for (int i = r.size() - 1; i >= 0; i--)
+		work.push_back(first + i);
+}
+/**
+ * жworkջµķܷlook
+ * ΪյķսһΪյķܷlookʼ.
+ * 
+ * \param look
+ * \return 
+ */
+bool LLparser::can_follow(int look) {
+	for (int i = work.size() - 1; i >= 0; i--) {
+		int sym = nodes[work[i]].sym;
+		if (g.starts[sym * g.ncol + look])
+			return true;
+		if (g.is_term[sym] || !g.nullable_id[sym])
+			return false;
+	}
+	return false;
+}
+/**
+ * жworkջǷзlookʼlookΪͬţ
+ * Ϊ˱֤ÿγĴޣֻջ64.
+ * 
+ * \param look
+ * \return 
+ */
+bool LLparser::wanted(int look) {
+	for (int i = work.size() - 1; i >= 0 && i >= (int)work.size() - 64; i--) {
+		int row = nodes[work[i]].sym * g.ncol;
+		if (g.starts[row + look] || g.sync[row + look])
+			return true;
+	}
+	return false;
+}
+/**
+ * Ӹ㿪ʼ﷨
+ * һҪӡı.
+ * 
+ */
+void LLparser::render() {
+	parse_res.clear();
+	if (nodes.empty())
+		return;
+	vector< pair<int, int>> stack;
+	stack.push_back(make_pair(0, 0));
+	while (!stack.empty()) {
+		int id = stack.back().first;
+		int d = stack.back().second;
+		stack.pop_back();
+		if (!nodes[id].visited)
+			continue;
+		parse_res.append(d, '\t');
+		parse_res += sym_name[nodes[id].sym];
+		parse_res += '\n';
+		for (int i = nodes[id].cnt - 1; i >= 0; i--)
+			stack.push_back(make_pair(nodes[id].first + i, d + 1));
+	}
+}
+/**
+ * nodesе﷨תflat_tree
+ * renderһδջĽ㣬ϵսûжӦtoken.
+ * 
+ * \return 
+ */
+flat_tree LLparser::to_flat() {
+	flat_tree t;
+	if (nodes.empty())
+		return t;
+	t.kind.reserve(nodes.size()); t.tok.reserve(nodes.size());
+	t.first.reserve(nodes.size()); t.size.reserve(nodes.size());
+	vector<int> post(nodes.size(), -1);	///flat_treeе±
+	vector< pair<int, bool>> stack;	///secondΪtrueʾѾ
+	stack.push_back(make_pair(0, false));
+	while (!stack.empty()) {
+		int id = stack.back().first;
+		bool done = stack.back().second;
+		stack.pop_back();
+		node& nd = nodes[id];
+		if (!nd.visited)
+			continue;
+		if (!done && nd.cnt > 0) {
+			stack.push_back(make_pair(id, true));
+			for (int i = nd.cnt - 1; i >= 0; i--)
+				stack.push_back(make_pair(nd.first + i, false));
+			continue;
+		}
+		if (nd.cnt == 0) {
+			post[id] = t.add(nd.sym, g.is_term[nd.sym] ? nd.first : -1, -1, 1);
+			continue;
+		}
+		int fc = -1, sz = 1;
+		for (int i = 0; i < nd.cnt; i++) {
+			int c = post[nd.first + i];
+			if (c == -1)
+				continue;
+			if (fc == -1)
+				fc = c;
+			sz += t.size[c];
+		}
+		post[id] = t.add(nd.sym, -1, fc, sz);
+	}
+	return t;
+}
+/**
+ * ִʺķ򰴿ոָɴкϢtoken
+ * ֻGeneratorȡķԴLexAnalyzer.
  * 
  * \param s
  * \return 
@@ -344,74 +1126,91 @@ vector<token> split_word(string s) {
 }
 /**
  * ﷨
- * նӦ룬ȷִʣ
- * dequeģջTop-down﷨.
+ * նӦ룬LexAnalyzerõűŵtoken
+ * vectorģջջֻ±꣬Top-down﷨
+ * ͬʱnodesн﷨ͳһӡ.
  * 
  * \param s
  */
 void LLparser::execute(string s) {
-	vector<token> split_res = split_word(s);
-	for (int i = split_res.size() - 1; i >= 0; i--)
-		input.push_front(split_res[i]);
-	work.push_front(token("program", -1, -1, -1));
-	depth.push_front(0);
+	LexAnalyzer lex(g);
+	lex.execute(s);
+	vector<token>& split_res = lex.res;
+	int n = split_res.size();
+	input.resize(n);
+	input_line.resize(n);
+	for (int i = 0; i < n; i++) {
+		input[i] = split_res[i].type;
+		input_line[i] = split_res[i].line_num;
+	}
+	nodes.clear();
+	///ȷÿtokenԼӦչԤʱadd_children
+	nodes.reserve(4 * n + 16);
+	work.clear();
+	work.reserve(n + 64);
+	nodes.push_back(node(g.sid["program"]));
+	work.push_back(0);
 	int curline = 1;
-	int depthhead;
-	token workhead, inputhead;
-	string old_parse_res;
-	while (!input.empty()) {
-		old_parse_res = parse_res;
-		workhead = work.front();
-		inputhead = input.front();
-		depthhead = depth.front();
-		work.pop_front();
-		depth.pop_front();
-		for (int i = 0; i < depthhead; i++)
-			parse_res += '\t';
-		parse_res += workhead.str;
-		parse_res += '\n';
-		//cout << work.size() << ' ' << input.size() << ' ' << endl;
-		//cout << workhead.str << ' ' << inputhead.str << ' ' <<  endl;
-		if (g.term.count(workhead.str) && workhead.str == inputhead.str) {
-			input.pop_front();
-			curline = inputhead.line_num;
-			//do nothing
-		}
-		else if (g.nonterm.count(workhead.str) && g.table[g.sid[workhead.str]][g.sid[inputhead.str]] != -1) {
-			int pid = g.table[g.sid[workhead.str]][g.sid[inputhead.str]];
-			vector<string> p = g.productions[pid];
-			if (p.size() == 2 && p[1] == "E") {
-				for (int i = 0; i < depthhead + 1; i++)
-					parse_res += '\t';
-				parse_res += "E\n";
-			}
-			else {
-				for (int i = p.size() - 1; i >= 1; i--) {
-					work.push_front(token(p[i],-1,-1,curline));
-					depth.push_front(depthhead + 1);
-				}
-			}
+	int ip = 0;
+	///inserted¼һγɹƥϵս
+	int inserted = 0;
+	while (ip < n && !work.empty()) {
+		uint32_t workhead = work.back();
+		work.pop_back();
+		nodes[workhead].visited = true;
+		int sym = nodes[workhead].sym;
+		int look = input[ip];
+		if (g.is_term[sym] && sym == look) {
+			curline = input_line[ip];
+			nodes[workhead].first = ip;
+			ip++;
+			inserted = 0;
+			continue;
 		}
-		///޸inputջʹÿ﷨ԽУͬʱع
-		else {
-			if (g.term.count(workhead.str)) {
-				e.add(UNEXPECTED_SYMBOL, workhead.str, curline);
-				input.push_front(token(workhead.str, -1, -1, curline));
-			}
-			else if (g.nullable[workhead.str]) {
-				for (int i = 0; i < depthhead + 1; i++)
-					parse_res += '\t';
-				parse_res += "E\n";
-				continue;
-			}
-			work.push_front(token(workhead.str, -1, -1, curline));
-			depth.push_front(depthhead);
-			parse_res = old_parse_res;
+		int pid = g.is_term[sym] ? -1 : g.dense[sym * g.ncol + look];
+		if (pid != -1) {
+			add_children(workhead, pid);
+			continue;
+		}
+		///nullableķսջҪtokenʱֱƳE
+		if (!g.is_term[sym] && g.nullable_id[sym] && wanted(look)) {
+			add_children(workhead, g.null_pid_id[sym]);
+			continue;
+		}
+		///ȱٵսϺֱܼΪѾƥ䣬
+		if (g.is_term[sym] && inserted < max_insert && can_follow(look)) {
+			e.add(UNEXPECTED_SYMBOL, sym_name[sym], curline);
+			inserted++;
+			continue;
 		}
+		///panic modeܿʼsymҲͬеtokenÿγmax_skip
+		///սͬǲܼ֮token
+		int row = sym * g.ncol;
+		int skipped = 0;
+		while (ip < n && !g.starts[row + input[ip]] && skipped < max_skip &&
+			!(g.is_term[sym] ? can_follow(input[ip]) : g.sync[row + input[ip]])) {
+			e.add(SKIPPED_SYMBOL, split_res[ip].str, input_line[ip]);
+			curline = input_line[ip];
+			ip++;
+			skipped++;
+		}
+		///ܿʼsymtoken·sym
+		///nullableķսƳEΪsymȱʧ
+		if (ip < n && g.starts[row + input[ip]]) {
+			nodes[workhead].visited = false;
+			work.push_back(workhead);
+		}
+		else if (!g.is_term[sym] && g.nullable_id[sym])
+			add_children(workhead, g.null_pid_id[sym]);
+		else
+			e.add(UNEXPECTED_SYMBOL, sym_name[sym], curline);
 	}
 	if (!work.empty())
 		e.add(EARLY_EOF,"", curline);
+	else if (ip < n)
+		e.add(SKIPPED_SYMBOL, split_res[ip].str, input_line[ip]);
 	e.report();
+	render();
 	cout << parse_res;
 }
 
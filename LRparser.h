@@ -15,6 +15,8 @@
 #include <vector>
 #include <deque>
 #include <set>
+#include <memory>
+#include <cstdint>
 using namespace std;
 /* Ҫ޸׼뺯 */
 void read_prog(string& prog)
@@ -54,14 +56,15 @@ struct entry {
 vector<token> split_word(string input);
 
 ///errorö
-enum{UNEXPECTED_SYMBOL,EARLY_EOF,REPEAT_ENTRY};
+enum{UNEXPECTED_SYMBOL,EARLY_EOF,REPEAT_ENTRY,SKIPPED_SYMBOL,REPLACED_SYMBOL};
 struct error {
 	int type;
+	string word;
 	int line_num;
 
 	error() {}
-	error(int t, int ln) {
-		type = t; line_num = ln;
+	error(int t, string w, int ln) {
+		type = t; word = w; line_num = ln;
 	}
 };
 /**
@@ -72,11 +75,11 @@ private:
 	vector<error> errors;
 public:
 	bool report();
-	void add(int error, int ln);
+	void add(int error, string word, int ln);
 };
 
-void ErrorHandler::add(int etype, int ln) {
-	errors.push_back(error(etype, ln));
+void ErrorHandler::add(int etype, string word, int ln) {
+	errors.push_back(error(etype, word, ln));
 }
 
 bool ErrorHandler::report() {
@@ -88,11 +91,17 @@ bool ErrorHandler::report() {
 			cout << "﷨󣬵" << e.line_num << "У";
 			switch (e.type) {
 			case UNEXPECTED_SYMBOL:
-				cout << "ȱ\";\"" << endl;
+				cout << "ȱ\"" << e.word << "\"" << endl;
 				break;
 			case EARLY_EOF:
 				cout << "ﲻӦEOF,Ĵ벻," << endl;
 				break;
+			case SKIPPED_SYMBOL:
+				cout << "\"" << e.word << "\"" << endl;
+				break;
+			case REPLACED_SYMBOL:
+				cout << e.word << endl;
+				break;
 			default:
 				cout << "unkown error" << endl;
 			}
@@ -107,6 +116,163 @@ struct item {
 	item(){}
 	item(int p, int i) { pid = p; idx = i; }
 };
+/**
+ * bump-pointerڴأ﷨Ľڵ㶼䣬
+ * ֻƶָ룬resetO(1)ͷȫڵ㣬ڴ´θ.
+ */
+class Arena {
+private:
+	vector< unique_ptr<char[]>> blocks;
+	vector<size_t> sizes;
+	size_t block_size;
+	int cur;	///ǰʹõڴ
+	size_t used;	///ǰڴʹõֽ
+public:
+	Arena(size_t bs = 1 << 16) { block_size = bs; cur = -1; used = 0; }
+	void* alloc(size_t n);
+	void reset() { cur = -1; used = 0; }
+	template <class T>
+	T* make() { return new (alloc(sizeof(T))) T(); }
+};
+/**
+ * nֽڣ8ֽڶ룬
+ * ǰŲʱһ飬ûкʵĿϵͳ.
+ * 
+ * \param n
+ * \return 
+ */
+void* Arena::alloc(size_t n) {
+	n = (n + 7) & ~size_t(7);
+	if (cur < 0 || used + n > sizes[cur]) {
+		cur++;
+		if (cur == blocks.size() || sizes[cur] < n) {
+			size_t sz = n > block_size ? n : block_size;
+			blocks.insert(blocks.begin() + cur, unique_ptr<char[]>(new char[sz]));
+			sizes.insert(sizes.begin() + cur, sz);
+		}
+		used = 0;
+	}
+	void* p = blocks[cur].get() + used;
+	used += n;
+	return p;
+}
+/**
+ * ﷨Ľڵ㣬ڹԼʱԵϽ.
+ * lenstateʹãڵ״̬ǵtokenͺһtokenͬʱ
+ * LRĶȫһ.
+ */
+struct cst_node {
+	int sym;	///ű
+	int pid;	///ԼõĲʽidҶΪ-1
+	int tok;	///ҶӶӦtokensе±꣬ڲڵΪһtoken±꣬ղʽΪ-1
+	int cnt;	///ղʽΪ0
+	int len;	///ǵtoken
+	int state;	///ƽԼڵ֮ǰջ״̬ҶΪ-1
+	cst_node** kids;
+};
+///﷨ڵ
+enum { AST_BLOCK, AST_ASSIGN, AST_IF, AST_WHILE, AST_BINOP, AST_LITERAL, AST_ID };
+/**
+ * ﷨Ľڵ㣬
+ * a/b/cthen֧Ҳelse֧
+ * aʼnext.
+ */
+struct ast_node {
+	int kind;
+	int tok;	///ʶֻӦtokensе±
+	ast_node* a;
+	ast_node* b;
+	ast_node* c;
+	ast_node* next;
+};
+/**
+ * ŵıƽ﷨ĸ鰴±룬ָ룬
+ * iռ[i - size[i] + 1, i]һi - 1
+ * ǰһֵc - size[c]ÿ14ֽڣֱӰֽдļ.
+ */
+struct flat_tree {
+	vector<uint16_t> kind;	///ű
+	vector<int> tok;	///սӦtoken±꣬ûʱΪ-1
+	vector<int> first;	///һӵ±꣬ҶΪ-1
+	vector<int> size;	///ĽԼ
+
+	int count() const { return kind.size(); }
+	int add(int k, int t, int f, int s) {
+		kind.push_back(k); tok.push_back(t); first.push_back(f); size.push_back(s);
+		return kind.size() - 1;
+	}
+	void save(ostream& out) const;
+	bool load(istream& in);
+};
+/**
+ * ддĸԭʼֽ.
+ * 
+ * \param out
+ */
+void flat_tree::save(ostream& out) const {
+	int n = count();
+	out.write((const char*)&n, sizeof(n));
+	out.write((const char*)kind.data(), n * sizeof(uint16_t));
+	out.write((const char*)tok.data(), n * sizeof(int));
+	out.write((const char*)first.data(), n * sizeof(int));
+	out.write((const char*)size.data(), n * sizeof(int));
+}
+/**
+ * saveдݣʧʱfalse.
+ * 
+ * \param in
+ * \return 
+ */
+bool flat_tree::load(istream& in) {
+	int n = 0;
+	if (!in.read((char*)&n, sizeof(n)) || n < 0)
+		return false;
+	kind.resize(n); tok.resize(n); first.resize(n); size.resize(n);
+	in.read((char*)kind.data(), n * sizeof(uint16_t));
+	in.read((char*)tok.data(), n * sizeof(int));
+	in.read((char*)first.data(), n * sizeof(int));
+	in.read((char*)size.data(), n * sizeof(int));
+	return (bool)in;
+}
+/**
+ * ѹ﷨ɭ֣SPPFĽ㣬
+ * ͬһŸͬһtokenƵһ㣬
+ * ÿƵʽһsppf_packжpack˵.
+ */
+struct sppf_node {
+	int sym;	///ű
+	int start;	///ǵtoken[start, end)
+	int end;
+	int pack;	///һsppf_pack±꣬սΪ-1Ӧtoken±start
+};
+struct sppf_pack {
+	int next;	///ͬһһƵûʱΪ-1
+	int kid;	///LRparser::sppf_kidsеʼ±
+	int cnt;	///
+};
+/**
+ * ͼṹջGSSĽ㣬
+ * ÿָһĽ㣬ϱŶӦSPPF.
+ */
+struct gss_link {
+	int to;
+	int label;
+};
+struct gss_node {
+	int state;
+	int pos;	///ʱѾƽtoken
+	vector<gss_link> links;
+};
+/**
+ * SLR tableͳϢ.
+ */
+struct table_stats {
+	int unit_removed;	///ƹĵʽת
+	int merged;	///ϲĵȼ״̬
+	int defred;	///ĬϹԼ״̬
+	int live;	///Կɴ״̬
+	table_stats() { unit_removed = merged = defred = live = 0; }
+};
 
 /**
  * Generatorܹ࣬淶ķ"|"תɶʽзָEʾգ
@@ -123,6 +289,14 @@ public:
 	vector< set<string>> follow;
 	vector< vector<int>> table;
 	vector< vector<entry>> slrtable;
+	vector<int> defred;
+	int ncol;
+	vector<int> flat;	///slrtableչÿΪnum*4+typeΪ-1ĬϹԼ
+	vector<int> rlen;	///ʽҲȥEĳ
+	vector<int> lhs;	///ʽ󲿵ķű
+	int eof = -1;	///$ķű
+	int ident = -1;	///IDķűţķûIDʱΪ-1
+	map<int, vector<entry>> conflicts;	///гͻı״̬ *  + Уϵȫ
 	map<string, int> sid;
 	vector< vector<item>> canonical_collection;
 	Generator();
@@ -137,6 +311,11 @@ public:
 	bool repeat_item(vector<item> it, int i);
 	void generate_canonical_collection();
 	void generate_SLRtable();
+	int unit_state(int s, const set<int>& keep);
+	vector<bool> live_states();
+	table_stats optimize_SLRtable(set<int> keep);
+	void generate_flat();
+	void add_conflict(int s, int c, entry old_en, entry new_en);
 };
 
 Generator::Generator() {}
@@ -202,8 +381,10 @@ void Generator::generate_dic() {
 	}
 	for (int i = 0; i < nonterm.size() + 1; i++)
 		table.push_back(row);
-	for (int i = 0; i < 200; i++)
+	for (int i = 0; i < 200; i++) {
 		slrtable.push_back(slrrow);
+		defred.push_back(-1);
+	}
 }
 /**
  * ȷսǷΪnullable
@@ -457,12 +638,37 @@ void Generator::generate_canonical_collection() {
 		for (auto it : statehead) {
 			if (it.idx == productions[it.pid].size() - 1||
 				(productions[it.pid].size()==2&&productions[it.pid][1]=="E")) {
-				for (auto f : follow[sid[productions[it.pid][0]]])
-					slrtable[idhead][sid[f]] = entry(REDUCE, it.pid);
+				for (auto f : follow[sid[productions[it.pid][0]]]) {
+					entry& cell = slrtable[idhead][sid[f]];
+					if (cell.type != -1 && !(cell.type == REDUCE && cell.num == it.pid))
+						add_conflict(idhead, sid[f], cell, entry(REDUCE, it.pid));
+					cell = entry(REDUCE, it.pid);
+				}
 			}
 		}
 	}
-	slrtable[0][sid[productions[0][1]]] = entry(ACC, -1);
+	///ACCnumԭGOTOĿ꣬ʼź滹ʱ
+	entry& start = slrtable[0][sid[productions[0][1]]];
+	start = entry(ACC, start.num);
+}
+/**
+ * ¼һͻıslrtableȻдĶ
+ * ͻȫGLRʹ.
+ * 
+ * \param s ״̬
+ * \param c 
+ * \param old_en ԭĶ
+ * \param new_en µĶ
+ */
+void Generator::add_conflict(int s, int c, entry old_en, entry new_en) {
+	vector<entry>& acts = conflicts[s * slrtable[s].size() + c];
+	if (acts.empty())
+		acts.push_back(old_en);
+	for (auto& en : acts) {
+		if (en.type == new_en.type && en.num == new_en.num)
+			return;
+	}
+	acts.push_back(new_en);
 }
 
 void Generator::generate_SLRtable() {
@@ -471,10 +677,238 @@ void Generator::generate_SLRtable() {
 	generate_follow();
 	generate_canonical_collection();
 }
+/**
+ * ж״̬sǷΪʽ״̬
+ * ֻͬһ A -> X Ĳʽreduce
+ * 򷵻ظòʽid򷵻-1.
+ * keepеĲʽ嶯Ϊʽ.
+ * 
+ * \param s
+ * \param keep
+ * \return 
+ */
+int Generator::unit_state(int s, const set<int>& keep) {
+	int pid = -1;
+	for (auto en : slrtable[s]) {
+		if (en.type == -1)
+			continue;
+		if (en.type != REDUCE)
+			return -1;
+		if (pid != -1 && en.num != pid)
+			return -1;
+		pid = en.num;
+	}
+	if (pid <= 0 || keep.count(pid))
+		return -1;
+	if (productions[pid].size() != 2 || productions[pid][1] == "E")
+		return -1;
+	return pid;
+}
+/**
+ * ״̬0SHIFTGOTOпɴ״̬.
+ * 
+ * \return 
+ */
+vector<bool> Generator::live_states() {
+	vector<bool> live(canonical_collection.size(), false);
+	deque<int> state_stack;
+	state_stack.push_front(0);
+	live[0] = true;
+	int w = slrtable[0].size();
+	while (!state_stack.empty()) {
+		int s = state_stack.front();
+		state_stack.pop_front();
+		vector<entry> next = slrtable[s];
+		///ͻеҲܵµ״̬
+		for (auto it = conflicts.lower_bound(s * w); it != conflicts.end() && it->first < (s + 1) * w; ++it)
+			next.insert(next.end(), it->second.begin(), it->second.end());
+		for (auto en : next) {
+			if ((en.type == SHIFT || en.type == GOTO) && !live[en.num]) {
+				live[en.num] = true;
+				state_stack.push_front(en.num);
+			}
+		}
+	}
+	return live;
+}
+/**
+ * SLR tableĺѡ
+ * 1. ƹû嶯ĵʽԼSHIFT/GOTOʽ״̬ʱֱԼGOTO״̬
+ * 2. ֻһֹԼ״̬ĬϹԼִʱز鿴ţ
+ * 3. ϲȫͬĵȼ״̬ղɴ״̬.
+ * ĬϹԼѱƳٵһ״̬ܴ.
+ * keepΪҪԼĲʽid嶯Ĳʽ.
+ * гͻ״̬ȲƹҲĬϹԼconflicts״̬ĺϲһ£GLRȡȫ.
+ * 
+ * \param keep
+ * \return 
+ */
+table_stats Generator::optimize_SLRtable(set<int> keep) {
+	table_stats stats;
+	int n = canonical_collection.size();
+	int w = slrtable[0].size();
+	vector<bool> conflicted(n, false);
+	for (auto& c : conflicts)
+		conflicted[c.first / w] = true;
+	///sSHIFT/GOTOʽ״̬ĶenĳֱӵԼGOTO״̬
+	auto bypass = [&](int s, entry& en) -> bool {
+		if (en.type != SHIFT && en.type != GOTO)
+			return false;
+		int pid = unit_state(en.num, keep);
+		if (pid == -1 || conflicted[en.num])
+			return false;
+		entry target = slrtable[s][sid[productions[pid][0]]];
+		if (target.type != GOTO && target.type != ACC)
+			return false;
+		if (en.type == SHIFT && target.type == ACC)
+			return false;
+		if (en.type == SHIFT)
+			en.num = target.num;
+		else
+			en = target;
+		return true;
+	};
+	///ʽж㣬ѭֱٱ仯
+	bool changed = true;
+	for (int round = 0; changed && round < n; round++) {
+		changed = false;
+		for (int s = 0; s < n; s++) {
+			for (auto &en : slrtable[s]) {
+				if (bypass(s, en)) {
+					stats.unit_removed++;
+					changed = true;
+				}
+			}
+		}
+		for (auto& c : conflicts) {
+			for (auto& en : c.second)
+				changed |= bypass(c.first / w, en);
+		}
+	}
+	vector<bool> live = live_states();
+	for (int s = 0; s < n; s++) {
+		if (!live[s] || conflicted[s])
+			continue;
+		int pid = -1;
+		for (auto en : slrtable[s]) {
+			if (en.type == -1)
+				continue;
+			if (en.type != REDUCE || (pid != -1 && en.num != pid)) {
+				pid = -1;
+				break;
+			}
+			pid = en.num;
+		}
+		if (pid != -1) {
+			defred[s] = pid;
+			stats.defred++;
+		}
+	}
+	///ĬϹԼͬ״̬Ϊһ£ϲС״̬
+	changed = true;
+	while (changed) {
+		changed = false;
+		live = live_states();
+		map< vector<int>, int> rep;
+		vector<int> to(n);
+		for (int s = 0; s < n; s++) {
+			to[s] = s;
+			if (!live[s])
+				continue;
+			vector<int> key;
+			key.push_back(defred[s]);
+			for (auto en : slrtable[s]) {
+				key.push_back(en.type);
+				key.push_back(en.num);
+			}
+			///ͻĶҲҪͬ-2
+			for (auto it = conflicts.lower_bound(s * w); it != conflicts.end() && it->first < (s + 1) * w; ++it) {
+				key.push_back(-2);
+				key.push_back(it->first - s * w);
+				for (auto en : it->second) {
+					key.push_back(en.type);
+					key.push_back(en.num);
+				}
+			}
+			if (rep.count(key)) {
+				to[s] = rep[key];
+				stats.merged++;
+				changed = true;
+			}
+			else
+				rep[key] = s;
+		}
+		for (int s = 0; s < n; s++) {
+			for (auto &en : slrtable[s]) {
+				if (en.type == SHIFT || en.type == GOTO)
+					en.num = to[en.num];
+			}
+		}
+		for (auto& c : conflicts) {
+			for (auto& en : c.second) {
+				if (en.type == SHIFT || en.type == GOTO)
+					en.num = to[en.num];
+			}
+		}
+	}
+	live = live_states();
+	for (int s = 0; s < n; s++) {
+		if (live[s]) {
+			stats.live++;
+			continue;
+		}
+		for (auto &en : slrtable[s])
+			en = entry(-1, -1);
+		defred[s] = -1;
+	}
+	///ϲ߲ɴ״̬ѾգǵĳͻҲҪ
+	for (auto it = conflicts.begin(); it != conflicts.end();) {
+		if (live[it->first / w])
+			++it;
+		else
+			it = conflicts.erase(it);
+	}
+	return stats;
+}
 
+/**
+ * slrtableչһάint飬ԤÿʽҪķ󲿱ţ
+ * ʱֻ±㣬ٱȽַ߲map.
+ * ĬϹԼ״̬жԼгͻı-1GLR.
+ * 
+ */
+void Generator::generate_flat() {
+	ncol = slrtable[0].size();
+	flat.assign(slrtable.size() * ncol, -1);
+	for (int s = 0; s < slrtable.size(); s++) {
+		for (int c = 0; c < ncol; c++) {
+			entry en = (defred[s] != -1) ? entry(REDUCE, defred[s]) : slrtable[s][c];
+			if (en.type == ACC)
+				flat[s * ncol + c] = (en.num < 0 ? 0 : en.num) * 4 + ACC;
+			else if (en.type != -1)
+				flat[s * ncol + c] = en.num * 4 + en.type;
+		}
+	}
+	rlen.clear();
+	lhs.clear();
+	for (auto& p : productions) {
+		int n = 0;
+		for (int i = 1; i < p.size(); i++) {
+			if (p[i] != "E")
+				n++;
+		}
+		rlen.push_back(n);
+		lhs.push_back(sid[p[0]]);
+	}
+	eof = sid["$"];
+	ident = sid.count("ID") ? sid["ID"] : -1;
+	for (auto& c : conflicts)
+		flat[c.first] = -1;
+}
 /**
  * ִʺ
- * ַָɴкϢtoken.
+ * ķ򰴿ոָɴкϢtoken
+ * ֻGeneratorȡķԴLexAnalyzer.
  * 
  * \param s
  * \return 
@@ -513,112 +947,1563 @@ vector<token> split_word(string s) {
 	return split_res;
 }
 
+/**
+ * жַ͵ĺLexicalAnalysis.hͬ.
+ * 
+ * \param c
+ * \return 
+ */
+bool isDigit(char c) {
+	if (c >= '0' && c <= '9')
+		return true;
+	return false;
+}
+bool isAlpha(char c) {
+	if (c >= 'a' && c <= 'z')
+		return true;
+	if (c >= 'A' && c <= 'Z')
+		return true;
+	if (c == '_')
+		return true;
+	return false;
+}
+/**
+ * ʷLexicalAnalysis.hеLexAnalyzerд
+ * ֱɨԴõкŵtokenҪȰСոз֣
+ * ͨtidķеսӳɷűţ
+ * սıʶΪIDּΪNUM಻ʶĴʱΪunknown.
+ */
+class LexAnalyzer {
+public:
+	string input;
+	map<string, int> tid;
+	int unknown;
+	int line;
+	vector<token> res;
+	LexAnalyzer(Generator& g);
+	void execute(string input);
+	void add(string word, string sym);
+	int get_num(int pos, string word);
+	int get_operator(int pos, string word);
+	int get_alpha(int pos, string word);
+};
+/**
+ * ķսʼid.
+ * 
+ * \param g
+ */
+LexAnalyzer::LexAnalyzer(Generator& g) {
+	for (auto t : g.term) {
+		if (t != "E" && t != "$")
+			tid[t] = g.sid[t];
+	}
+	unknown = g.sid.size();
+	line = 1;
+}
+/**
+ * ¼һtokenwordΪԭģsymΪӦս
+ * tokentypeΪսı.
+ * 
+ * \param word
+ * \param sym
+ */
+void LexAnalyzer::add(string word, string sym) {
+	auto it = tid.find(sym);
+	res.push_back(token(word, -1, it == tid.end() ? unknown : it->second, line));
+}
+/**
+ * ֣tokenһַλ.
+ * 
+ * \param pos
+ * \param word
+ * \return 
+ */
+int LexAnalyzer::get_num(int pos, string word) {
+	int j = pos;
+	int state = 0;
+	while (j + 1 < input.length()) {
+		j++;
+		if (isDigit(input[j]))
+			;
+		else if (input[j] == '.' && state == 0)
+			state = 1;
+		else
+			break;
+		word += input[j];
+	}
+	add(word, "NUM");
+	return pos + word.length() - 1;
+}
+/**
+ * ͽַսʱȡģ
+ * עͣtokenһַλ.
+ * 
+ * \param pos
+ * \param word
+ * \return 
+ */
+int LexAnalyzer::get_operator(int pos, string word) {
+	int i = pos;
+	if (i + 1 < input.length()) {
+		if (input[i] == '/' && input[i + 1] == '/') {
+			while (i + 1 < input.length() && input[i + 1] != '\n')
+				i++;
+			return i;
+		}
+		if (input[i] == '/' && input[i + 1] == '*') {
+			i += 2;
+			while (i + 1 < input.length() && !(input[i] == '*' && input[i + 1] == '/')) {
+				if (input[i] == '\n')
+					line++;
+				i++;
+			}
+			return i + 1;
+		}
+		if (tid.count(input.substr(i, 2)))
+			word += input[i + 1];
+	}
+	add(word, word);
+	return pos + word.length() - 1;
+}
+/**
+ * ܹؼֻ߱ʶtokenһַλ.
+ * 
+ * \param pos
+ * \param word
+ * \return 
+ */
+int LexAnalyzer::get_alpha(int pos, string word) {
+	int j = pos;
+	while (j + 1 < input.length() && (isDigit(input[j + 1]) || isAlpha(input[j + 1]))) {
+		j++;
+		word += input[j];
+	}
+	add(word, tid.count(word) ? word : "ID");
+	return pos + word.length() - 1;
+}
+/**
+ * ɨ룬ַѡtokenķʽ.
+ * 
+ * \param raw_input
+ */
+void LexAnalyzer::execute(string raw_input) {
+	input = raw_input;
+	res.clear();
+	res.reserve(input.length() / 2 + 1);
+	for (int i = 0; i < input.length(); i++) {
+		char c = input[i];
+		if (c == '\n')
+			line++;
+		else if (c == ' ' || c == '\t' || c == '\r')
+			;
+		else if (isDigit(c))
+			i = get_num(i, string(1, c));
+		else if (isAlpha(c))
+			i = get_alpha(i, string(1, c));
+		else
+			i = get_operator(i, string(1, c));
+	}
+}
+
 class  LRparser {
 private:
 	vector<token> tokens;
-	deque<token> input;
 	deque<token> work;
 	deque<int> state;
 	vector<entry> op;
 	deque<string> output;
 	ErrorHandler e;
 	Generator g;
+	string rules;
+	int reduce_cnt = 0;
+	bool accepted = false;
+	bool gave_up = false;	///޷޸Ĵ֮붼
+	int curline = 1;
+	deque<token> held;	///token޸token
+	vector<int> repair_syms;	///Բ滻ս";"ǰ
+	vector<int> sim_state;	///try_repairѹ״̬
+	int repair_window = 3;	///޸ʱ󿴵token
+	int repair_budget = 64;	///һ޸ʱִеĶ
+	vector<int> fast_state;	///driveʹõ״̬ջε֮临
+	int fast_top = 0;	///driveʱջ±
+	vector<sppf_node> forest;
+	vector<sppf_pack> packs;
+	vector<int> sppf_kids;
+	vector<gss_node> gss;
+	Arena arena;
+	vector<int> prod_kind;	///ʽӦAST࣬arithexpr/multexprΪAST_ID+1Ϊ-1
+	ast_node* binop_chain(ast_node* left, cst_node* prime);
+	ast_node* collapse(cst_node* n);
+	bool step(token t);
+	int new_sppf(int sym, int start, int end, const int* kids, int cnt);
+	void add_pack(int id, const vector<int>& kids);
+	void glr_actions(int s, int a, vector<entry>& acts);
+	void glr_paths(int v, int left, int first_link, vector<int>& labels, vector< pair<int, vector<int>>>& ends);
+	double count_from(int id, vector<double>& memo);
+	int try_repair(const vector<int>& seq);
+	void recover();
+	vector< pair<cst_node*, int>> reparse_right;	///лûжھе
+	vector<cst_node*> reparse_stack;	///ֵջ
+	vector<cst_node*> reparse_dropped;	///б𿪻ɾľɽڵ
+	vector< vector<cst_node*>> spare;	///õĽڵ㣬ֿ
+	bool reparse_error = false;	///reparse_at﷨󣬻Ҳһ
+	vector<cst_node*> finger;	///һʱӸµ·
+	vector<int> finger_from;	///·Ͻڵ
+	vector<int> finger_idx;	///·Ͻڵڸڵе±
+	cst_node* reparse_at(cst_node* a, int start, int first, int last, const vector<cst_node*>& ins, int boundary);
 public:
 	void init_table(string raw_input);
+	table_stats optimize_table(set<int> keep);
+	LexAnalyzer lexer();
+	void reset();
+	void feed(token t);
+	void feed(const vector<token>& ts);
+	bool finish();
+	template <class V, class Shift, class Reduce>
+	int drive(const vector<int>& syms, vector<V>& values, Shift shift, Reduce reduce, vector<entry>* ops = nullptr);
 	vector<entry> execute(string input);
-	void show();
+	cst_node* build_cst(string input);
+	cst_node* reparse(cst_node* root, int first, int last, string text);
+	flat_tree build_flat(string input);
+	int glr_parse(string input);
+	double count_trees(int root);
+	void show_forest(int root);
+	ast_node* build_ast(cst_node* root);
+	void show_ast(ast_node* n);
+	void free_tree();
+	void show(bool compact = false);
+	void report_saving(string input, set<int> keep);
 };
 
 void LRparser::init_table(string raw_input) {
+	rules = raw_input;
 	g = Generator(raw_input);
 	g.generate_dic();
 	g.generate_first();
 	g.generate_follow();
 	g.generate_canonical_collection();
+	g.generate_flat();
+	repair_syms.clear();
+	repair_syms.push_back(g.sid[";"]);
+	for (auto t : g.term) {
+		if (t != "E" && t != "$" && t != ";")
+			repair_syms.push_back(g.sid[t]);
+	}
 }
 /**
- * ﷨
- * նӦ룬ȷִʣ
- * dequeģջBottom-up﷨.
+ * ɵSLR table
+ * Żopвټ¼ƹĵʽԼshowصʽЩ貹չʾƵ.
  * 
- * \param input_string
+ * \param keep ҪԼĲʽid
  * \return 
  */
-vector<entry> LRparser::execute(string input_string) {
-	tokens = split_word(input_string);
-	for (int i = tokens.size() - 1; i >= 0; i--)
-		input.push_front(tokens[i]);
-	input.push_back(token("$", -1, -1, -1));
+table_stats LRparser::optimize_table(set<int> keep) {
+	table_stats stats = g.optimize_SLRtable(keep);
+	g.generate_flat();
+	return stats;
+}
+/**
+ * ذķĴʷ
+ * ֶεʱΣΪλexecuteٰresͽfeedкŻۼ.
+ * 
+ * \return 
+ */
+LexAnalyzer LRparser::lexer() {
+	return LexAnalyzer(g);
+}
+/**
+ * ջͼ¼صʼ״̬
+ * ֮feedtokenfinish.
+ * 
+ */
+void LRparser::reset() {
+	work.clear();
+	state.clear();
+	op.clear();
+	e = ErrorHandler();
 	state.push_front(0);
+	reduce_cnt = 0;
+	accepted = false;
+	gave_up = false;
+	held.clear();
+	curline = 1;
+}
+/**
+ * һtokenƽһֱԼƽΪֹ
+ * ձʱĶջfalse.
+ * 
+ * \param t token.typeGenerator::sidеı
+ * \return 
+ */
+bool LRparser::step(token t) {
+	token inputhead = t; int statehead; entry curop;
 
-	token workhead; token inputhead; int statehead; entry curop; int curline=1;
-
-	while (!input.empty()) {
+	while (!accepted) {
+		if (state.empty())
+			reset();
 		statehead = state.front();
-		inputhead = input.front();
 		//cout << "line " << curline << " : " << statehead << ' ' << inputhead.str << ' ';
-		curop = g.slrtable[statehead][g.sid[inputhead.str]];
+		///ĬϹԼ״̬Ҫ鿴
+		if (g.defred[statehead] != -1)
+			curop = entry(REDUCE, g.defred[statehead]);
+		else
+			curop = g.slrtable[statehead][inputhead.type];
 		//cout<<curop.type<<' '<<curop.num<<endl;
-		if (curop.type == ACC)
+		if (curop.type == ACC) {
+			accepted = true;
 			break;
+		}
 		if (curop.type == SHIFT) {
 			work.push_front(inputhead);
-			input.pop_front();
 			state.push_front(curop.num);
+			curline = inputhead.line_num;
+			break;
 		}
 		if (curop.type == REDUCE) {
 			op.push_back(curop);
-			for (int i = 1; i < g.productions[curop.num].size(); i++) {
-				if (g.productions[curop.num][i] == "E")
-					continue;
+			reduce_cnt++;
+			for (int i = g.rlen[curop.num]; i > 0; i--) {
 				work.pop_front();
 				state.pop_front();
 			}
 			work.push_front(token(g.productions[curop.num][0], -1, -1, inputhead.line_num));
-			entry temp = g.slrtable[state.front()][g.sid[g.productions[curop.num][0]]];
+			entry temp = g.slrtable[state.front()][g.lhs[curop.num]];
 			//cout << state.front() << ' ' << g.productions[curop.num][0] << ' ' << temp.type << ' ' << temp.num << endl;
 			state.push_front(temp.num);
-			if (temp.type == ACC)
+			if (temp.type == ACC && inputhead.type == g.eof) {
+				accepted = true;
 				break;
+			}
 		}
-		if (curop.type == -1) {
-			input.push_front(token(";", -1, -1, curline));
-			e.add(UNEXPECTED_SYMBOL, curline);
-		}
+		if (curop.type == -1)
+			return false;
 		curline = inputhead.line_num;
 	}
+	return true;
+}
+/**
+ * һtokenջкŶڳԱԷֶ.
+ * Ȱѳtoken֮repair_windowtokenheld
+ * չˣfinishʱrecoverѡ޸ʽûгʱӳ.
+ * ѾACC߷tokenᱻ.
+ * 
+ * \param t token.typeGenerator::sidеı
+ */
+void LRparser::feed(token t) {
+	if (accepted || gave_up)
+		return;
+	if (!held.empty()) {
+		held.push_back(t);
+		if (held.size() > repair_window)
+			recover();
+		return;
+	}
+	if (!step(t))
+		held.push_back(t);
+}
+/**
+ * ڲĶstateջŷseq
+ * ԼʵջԪֻ¼ѹ״̬sim_stateУ
+ * ִrepair_budget֤ÿγĴ.
+ * رƽtokenACCʱseq.size() + 1.
+ * 
+ * \param seq
+ * \return 
+ */
+int LRparser::try_repair(const vector<int>& seq) {
+	const int* tab = g.flat.data();
+	int ncol = g.ncol;
+	int depth = 0;	///ѾʵջԪظ
+	sim_state.clear();
+	int i = 0;
+	for (int steps = 0; i < seq.size() && steps < repair_budget; steps++) {
+		int top = sim_state.empty() ? state[depth] : sim_state.back();
+		int a = tab[top * ncol + seq[i]];
+		if (a < 0)
+			return i;
+		int num = a >> 2;
+		if ((a & 3) == SHIFT) {
+			sim_state.push_back(num);
+			i++;
+		}
+		else if ((a & 3) == REDUCE) {
+			for (int k = 0; k < g.rlen[num]; k++) {
+				if (!sim_state.empty())
+					sim_state.pop_back();
+				else
+					depth++;
+			}
+			top = sim_state.empty() ? state[depth] : sim_state.back();
+			int go = tab[top * ncol + g.lhs[num]];
+			if (go < 0)
+				return i;
+			if ((go & 3) == ACC && seq[i] == g.eof)
+				return seq.size() + 1;
+			sim_state.push_back(go >> 2);
+		}
+		else
+			return i;
+	}
+	return i;
+}
+/**
+ * Burke-Fisherʽľֲ޸
+ * held[0]γǰһսɾ滻һս
+ * try_repair޸held߶ԶѡߵԶģͬʱ˳ȣ
+ * ";"޸ǰ.
+ * ֻԽheld[0]޸ÿ޸һtokenʱԵģ
+ * $ǰûпõĲʱEOF.
+ * 
+ */
+void LRparser::recover() {
+	token bad = held.front();
+	vector<int> ctx;
+	for (auto& t : held)
+		ctx.push_back(t.type);
+	int best = 0, kind = -1, sym = -1;
+	vector<int> seq;
+	for (auto c : repair_syms) {
+		seq.assign(1, c);
+		seq.insert(seq.end(), ctx.begin(), ctx.end());
+		int got = try_repair(seq) - 1;
+		if (got > best) {
+			best = got; kind = UNEXPECTED_SYMBOL; sym = c;
+		}
+	}
+	if (bad.type != g.eof) {
+		seq.assign(ctx.begin() + 1, ctx.end());
+		int got = 1 + try_repair(seq);
+		if (got > best) {
+			best = got; kind = SKIPPED_SYMBOL;
+		}
+		for (auto c : repair_syms) {
+			if (c == bad.type)
+				continue;
+			seq.assign(1, c);
+			seq.insert(seq.end(), ctx.begin() + 1, ctx.end());
+			got = try_repair(seq);
+			if (got > best) {
+				best = got; kind = REPLACED_SYMBOL; sym = c;
+			}
+		}
+	}
+	deque<token> rest;
+	rest.swap(held);
+	string name;
+	for (auto& p : g.sid) {
+		if (p.second == sym)
+			name = p.first;
+	}
+	if (kind == UNEXPECTED_SYMBOL) {
+		e.add(UNEXPECTED_SYMBOL, name, curline);
+		step(token(name, -1, sym, curline));
+	}
+	else if (kind == SKIPPED_SYMBOL) {
+		e.add(SKIPPED_SYMBOL, bad.str, bad.line_num);
+		rest.pop_front();
+	}
+	else if (kind == REPLACED_SYMBOL) {
+		e.add(REPLACED_SYMBOL, "\"" + bad.str + "\"ӦΪ\"" + name + "\"", bad.line_num);
+		rest.front() = token(name, -1, sym, bad.line_num);
+	}
+	else {
+		e.add(EARLY_EOF, "", curline);
+		gave_up = true;
+		return;
+	}
+	for (auto& t : rest)
+		feed(t);
+}
 
+void LRparser::feed(const vector<token>& ts) {
+	for (int i = 0; i < ts.size() && !accepted; i++)
+		feed(ts[i]);
+}
+/**
+ * $
+ * ǷѾACC.
+ * 
+ * \return 
+ */
+bool LRparser::finish() {
+	feed(token("$", -1, g.eof, -1));
+	while (!held.empty() && !accepted && !gave_up)
+		recover();
+	return accepted;
+}
+/**
+ * ָĿٷѭ
+ * symsѾתõķűţ$β״̬ջֵջԤȷõ飬
+ * valuesֻΪֵջĴ洢VҪĬϹ죬
+ * ƽʱѹshift(i)Լʱreduce(pid, Ҳһֵָ, Ҳ)ķֵ滻Ҳ
+ * opsΪʱ¼ÿһιԼ.
+ * ɹʱ-1ʱvalues[1]ǿʼŵֵгͻıʱسtoken±꣬
+ * ջ±fast_topУʱԸfeed·Եõָ.
+ * 
+ * \param syms
+ * \param values
+ * \param shift
+ * \param reduce
+ * \param ops
+ * \return 
+ */
+template <class V, class Shift, class Reduce>
+int LRparser::drive(const vector<int>& syms, vector<V>& values, Shift shift, Reduce reduce, vector<entry>* ops) {
+	const int* tab = g.flat.data();
+	const int* rlen = g.rlen.data();
+	const int* lhs = g.lhs.data();
+	int ncol = g.ncol;
+	int cap = syms.size() + 64;
+	if (fast_state.size() < cap)
+		fast_state.resize(cap);
+	if (values.size() < cap)
+		values.resize(cap);
+	int* st = fast_state.data();
+	V* val = values.data();
+	int top = 0;	///ջ±꣬val[k]Ӧst[k]ƽԼõֵ
+	st[0] = 0;
+	int i = 0, n = syms.size();
+	while (i < n) {
+		if (top + 1 >= cap) {
+			cap *= 2;
+			fast_state.resize(cap);
+			values.resize(cap);
+			st = fast_state.data();
+			val = values.data();
+		}
+		int a = tab[st[top] * ncol + syms[i]];
+		if (a < 0) {
+			fast_top = top;
+			return i;
+		}
+		int num = a >> 2;
+		if ((a & 3) == SHIFT) {
+			st[++top] = num;
+			val[top] = shift(i);
+			i++;
+		}
+		else if ((a & 3) == REDUCE) {
+			int len = rlen[num];
+			if (ops != nullptr)
+				ops->push_back(entry(REDUCE, num));
+			V v = reduce(num, val + top - len + 1, len);
+			top -= len;
+			int go = tab[st[top] * ncol + lhs[num]];
+			if (go < 0) {
+				fast_top = top;
+				return i;
+			}
+			val[++top] = v;
+			if ((go & 3) == ACC && i == n - 1)
+				return -1;
+			st[top] = go >> 2;
+		}
+		///սϵGOTO/ACCҲǱеĿնֻĹԼʼŲ
+		else {
+			fast_top = top;
+			return i;
+		}
+	}
+	return n;
+}
+/**
+ * ﷨
+ * նӦ룬LexAnalyzerõűŵtoken
+ * driveٷʱһfeedȥԭķʽָ.
+ * 
+ * \param input_string
+ * \return 
+ */
+vector<entry> LRparser::execute(string input_string) {
+	LexAnalyzer lex(g);
+	lex.execute(input_string);
+	tokens = lex.res;
+	vector<int> syms;
+	syms.reserve(tokens.size() + 1);
+	for (auto& t : tokens)
+		syms.push_back(t.type);
+	syms.push_back(g.eof);
+	reset();
+	vector<char> values;
+	if (drive(syms, values, [](int) { return char(0); }, [](int, char*, int) { return char(0); }, &op) == -1) {
+		reduce_cnt = op.size();
+		accepted = true;
+		return op;
+	}
+	reset();
+	feed(tokens);
+	finish();
 	return op;
 }
 /**
- * չʾ﷨Ľ.
+ * 벢ÿιԼʱ﷨ڵ㶼arenaУ
+ * ҶӼ¼token±꣬ڲڵ¼ʽidͺ.
+ * ﷨ʱnullptrexecuteõϢ.
  * 
+ * \param input_string
+ * \return ڵ
  */
-void LRparser::show() {
-	e.report();
-	output.push_back("program");
-	string s = "";
-	cout << "program ";
-	for (int i = op.size() - 1; i >= 0; i--) {
-		//cout<<op[i]<<endl;
-		output.pop_back();
-		int num = op[i].num;
-		for (int j = 1; j < g.productions[num].size(); j++)
-			output.push_back(g.productions[num][j]);
-		while (!output.empty()) {
-			if (!g.term.count(output.back()))
-				break;
-			string s_add="";
-			if (output.back() != "E")
-				s_add = output.back() + " ";
-			s = s_add + s;
-			output.pop_back();
+cst_node* LRparser::build_cst(string input_string) {
+	LexAnalyzer lex(g);
+	lex.execute(input_string);
+	tokens.swap(lex.res);
+	finger.clear();
+	vector<int> syms;
+	syms.reserve(tokens.size() + 1);
+	for (auto& t : tokens)
+		syms.push_back(t.type);
+	syms.push_back(g.eof);
+	Arena& ar = arena;
+	const int* lhs = g.lhs.data();
+	vector<cst_node*> values;
+	auto shift = [&](int i) {
+		cst_node* n = ar.make<cst_node>();
+		n->sym = syms[i]; n->pid = -1; n->tok = i; n->cnt = 0; n->len = 1; n->state = -1; n->kids = nullptr;
+		return n;
+	};
+	auto reduce = [&](int pid, cst_node** rhs, int len) {
+		cst_node* n = ar.make<cst_node>();
+		n->sym = lhs[pid]; n->pid = pid; n->tok = -1; n->cnt = len; n->len = 0; n->kids = nullptr;
+		///ֵջfast_state±룬Ҳһ״̬
+		n->state = fast_state[rhs - values.data() - 1];
+		if (len > 0) {
+			n->kids = (cst_node**)ar.alloc(len * sizeof(cst_node*));
+			for (int i = 0; i < len; i++) {
+				n->kids[i] = rhs[i];
+				n->len += rhs[i]->len;
+				if (n->tok == -1)
+					n->tok = rhs[i]->tok;
+			}
+		}
+		return n;
+	};
+	if (drive(syms, values, shift, reduce) != -1)
+		return nullptr;
+	return values[1];
+}
+/**
+ * ﷨еfirstlast - 1tokenе˳ƣtextеtoken
+ * ֻ·ӰĲ֣µĸΧԻ﷨ʱnullptrԭ.
+ * Wagner-GrahamӸ޸ķΧ޸֮ǰͽڵaʼa״̬Ϊջ׷aķΧ
+ * ûб޸Ĳ״̬ͬʱƽĲ·
+ * atokenʱջʣһaͬĽڵ㣬˵a֮ķ̺ԭȫһڵ㼴ɣ
+ * Ҫaķʱߵԣ˵ϣҲǴõ
+ * ûжջ׾ͳ˵µȷʵ﷨󣬲.
+ * ԭ޸ĵģ𿪵ľɽڵ֮ãɵָ벻ʹã
+ * µtoken׷tokens棬tokensٰе˳УҶӵtokȻЧ.
+ * 
+ * \param root build_cstһreparseصĸ
+ * \param first
+ * \param last
+ * \param text 滻ȥԴƬ
+ * \return 
+ */
+cst_node* LRparser::reparse(cst_node* root, int first, int last, string text) {
+	if (root == nullptr || first < 0 || first > last || last > root->len)
+		return nullptr;
+	LexAnalyzer lex(g);
+	lex.execute(text);
+	vector<cst_node*> ins;
+	ins.reserve(lex.res.size());
+	for (auto& t : lex.res) {
+		cst_node* n = arena.make<cst_node>();
+		n->sym = t.type; n->pid = -1; n->tok = tokens.size(); n->cnt = 0; n->len = 1; n->state = -1; n->kids = nullptr;
+		tokens.push_back(t);
+		ins.push_back(n);
+	}
+	///Ұfirst - 1tokenһֱ쵽lastͽڵ㣬
+	///path[k]from[k]Ǹڵĵidx[k].
+	///stmtsҵݹԺһһε·˵Ȼ޸ķΧң
+	///ͬһ޸ʱֻ޸ĵľйأӴңֻϵĽڵ
+	vector<cst_node*>& path = finger;
+	vector<int>& from = finger_from;
+	vector<int>& idx = finger_idx;
+	if (path.empty() || path[0] != root) {
+		path.assign(1, root);
+		from.assign(1, 0);
+		idx.assign(1, -1);
+	}
+	while (path.size() > 1 && (from.back() >= first || from.back() + path.back()->len < last)) {
+		path.pop_back();
+		from.pop_back();
+		idx.pop_back();
+	}
+	while (first > 0) {
+		cst_node* n = path.back();
+		int s = from.back() + n->len, c = n->cnt - 1;
+		while (c >= 0 && s - n->kids[c]->len > first - 1)
+			s -= n->kids[c--]->len;
+		if (c < 0 || n->kids[c]->pid == -1 || s < last)
+			break;
+		path.push_back(n->kids[c]);
+		from.push_back(s - n->kids[c]->len);
+		idx.push_back(c);
+	}
+	int delta = ins.size() - (last - first);
+	int j = path.size() - 1, up = 1;
+	for (;;) {
+		cst_node* a = path[j];
+		int boundary = -1;
+		for (int k = j; k > 0 && boundary == -1; k--) {
+			cst_node* p = path[k - 1];
+			for (int c = idx[k] + 1; c < p->cnt && boundary == -1; c++) {
+				if (p->kids[c]->len > 0)
+					boundary = tokens[p->kids[c]->tok].type;
+			}
+		}
+		if (boundary == -1)
+			boundary = g.eof;
+		cst_node* x = reparse_at(a, from[j], first, last, ins, boundary);
+		if (x != nullptr) {
+			for (auto d : reparse_dropped) {
+				if (d->pid == -1)
+					continue;
+				if (spare.size() <= d->cnt)
+					spare.resize(d->cnt + 1);
+				spare[d->cnt].push_back(d);
+			}
+			path.resize(j + 1);
+			from.resize(j + 1);
+			idx.resize(j + 1);
+			path[j] = x;
+			if (j == 0)
+				return x;
+			path[j - 1]->kids[idx[j]] = x;
+			///a޸֮ǰһtoken䣬ֻҪĳ
+			if (delta != 0) {
+				for (int k = j - 1; k >= 0; k--)
+					path[k]->len += delta;
+			}
+			return root;
+		}
+		if (j == 0 || reparse_error)
+			return nullptr;
+		///ʧʱĲÿηlog()
+		j = j > up ? j - up : 0;
+		up *= 2;
+	}
+}
+/**
+ * a״̬Ϊջ·aǵķΧstartaھе㣬boundaryaս.
+ * һջ޸ķΧΪ룬ֻ״̬ԲʱŲ𿪣
+ * ޸ķΧڵľfirstʱµҶ.
+ * boundaryջֻʣһaͬĽڵʱڵ㣻
+ * ҪջµķŻҪƽboundaryʱnullptrֻгʱreparse_error.
+ * 
+ * \param a
+ * \param start
+ * \param first
+ * \param last
+ * \param ins µҶ
+ * \param boundary
+ * \return 
+ */
+cst_node* LRparser::reparse_at(cst_node* a, int start, int first, int last, const vector<cst_node*>& ins, int boundary) {
+	const int* tab = g.flat.data();
+	int ncol = g.ncol;
+	vector< pair<cst_node*, int>>& right = reparse_right;
+	vector<cst_node*>& val = reparse_stack;
+	vector<int>& st = fast_state;
+	right.clear();
+	reparse_dropped.clear();
+	reparse_error = false;
+	val.assign(1, nullptr);
+	st.assign(1, a->state);
+	auto expand = [&](cst_node* n, int s) {
+		reparse_dropped.push_back(n);
+		s += n->len;
+		for (int c = n->cnt - 1; c >= 0; c--) {
+			s -= n->kids[c]->len;
+			right.push_back(make_pair(n->kids[c], s));
+		}
+	};
+	int ip = 0, la_start = 0;
+	auto next = [&]() -> cst_node* {
+		for (;;) {
+			if (ip < ins.size() && (right.empty() || right.back().second >= first))
+				return ins[ip++];
+			if (right.empty())
+				return nullptr;
+			cst_node* n = right.back().first;
+			int s = right.back().second, e = s + n->len;
+			right.pop_back();
+			///ɷ¹Լ޸ķΧֱӶ
+			if (n->len == 0 || (s >= first && e <= last)) {
+				reparse_dropped.push_back(n);
+				continue;
+			}
+			///e < first֤tokenҲûб
+			if (n->pid == -1 || e < first || s >= last) {
+				la_start = s;
+				return n;
+			}
+			expand(n, s);
+		}
+	};
+	expand(a, start);
+	cst_node* la = next();
+	for (;;) {
+		if (la == nullptr && val.size() == 2 && val[1]->sym == a->sym)
+			return val[1];
+		int t = la == nullptr ? boundary : tokens[la->tok].type;
+		int act = tab[st.back() * ncol + t];
+		///ûжջʱĶȫͬ
+		if (act < 0) {
+			reparse_error = true;
+			return nullptr;
+		}
+		int num = act >> 2;
+		if ((act & 3) == REDUCE) {
+			int len = g.rlen[num];
+			if (len >= val.size())
+				return nullptr;
+			cst_node* n;
+			if (len < spare.size() && !spare[len].empty()) {
+				n = spare[len].back();
+				spare[len].pop_back();
+			}
+			else {
+				n = arena.make<cst_node>();
+				n->kids = len > 0 ? (cst_node**)arena.alloc(len * sizeof(cst_node*)) : nullptr;
+			}
+			int base = val.size() - len;
+			n->sym = g.lhs[num]; n->pid = num; n->tok = -1; n->cnt = len; n->len = 0; n->state = st[base - 1];
+			for (int c = 0; c < len; c++) {
+				n->kids[c] = val[base + c];
+				n->len += n->kids[c]->len;
+				if (n->tok == -1)
+					n->tok = n->kids[c]->tok;
+			}
+			val.resize(base);
+			st.resize(base);
+			int go = tab[st.back() * ncol + n->sym];
+			if (go < 0)
+				return nullptr;
+			val.push_back(n);
+			st.push_back(go >> 2);
+			continue;
+		}
+		if (la == nullptr)
+			return nullptr;
+		if (la->pid != -1) {
+			int go = tab[st.back() * ncol + la->sym];
+			if (la->state == st.back() && go >= 0) {
+				val.push_back(la);
+				st.push_back(go >> 2);
+			}
+			else
+				expand(la, la_start);
+		}
+		else {
+			val.push_back(la);
+			st.push_back(num);
+		}
+		la = next();
+	}
+}
+/**
+ * 벢ֱӵõflat_tree
+ * ԵϵĹԼ˳Ǻƽʱ׷ҶӣԼʱ׷Ӹ㣬
+ * ֵջֻ±.
+ * ﷨ʱؿ.
+ * 
+ * \param input_string
+ * \return 
+ */
+flat_tree LRparser::build_flat(string input_string) {
+	LexAnalyzer lex(g);
+	lex.execute(input_string);
+	tokens.swap(lex.res);
+	vector<int> syms;
+	syms.reserve(tokens.size() + 1);
+	for (auto& t : tokens)
+		syms.push_back(t.type);
+	syms.push_back(g.eof);
+	flat_tree t;
+	int cap = 3 * syms.size();
+	t.kind.reserve(cap); t.tok.reserve(cap); t.first.reserve(cap); t.size.reserve(cap);
+	const int* lhs = g.lhs.data();
+	auto shift = [&](int i) {
+		return t.add(syms[i], i, -1, 1);
+	};
+	auto reduce = [&](int pid, int* rhs, int len) {
+		if (len == 0)
+			return t.add(lhs[pid], -1, -1, 1);
+		int start = rhs[0] - t.size[rhs[0]] + 1;
+		return t.add(lhs[pid], -1, rhs[0], t.count() - start + 1);
+	};
+	vector<int> values;
+	if (drive(syms, values, shift, reduce) != -1)
+		return flat_tree();
+	return t;
+}
+/**
+ * forestĩβһSPPF㣬kidsΪָʾս.
+ * 
+ * \param sym
+ * \param start
+ * \param end
+ * \param kids
+ * \param cnt
+ * \return ±
+ */
+int LRparser::new_sppf(int sym, int start, int end, const int* kids, int cnt) {
+	sppf_node nd;
+	nd.sym = sym; nd.start = start; nd.end = end; nd.pack = -1;
+	if (kids != nullptr) {
+		sppf_pack pk;
+		pk.next = -1; pk.kid = sppf_kids.size(); pk.cnt = cnt;
+		sppf_kids.insert(sppf_kids.end(), kids, kids + cnt);
+		nd.pack = packs.size();
+		packs.push_back(pk);
+	}
+	forest.push_back(nd);
+	return forest.size() - 1;
+}
+/**
+ * idһƵʽѾͬĺʱظ.
+ * 
+ * \param id
+ * \param kids
+ */
+void LRparser::add_pack(int id, const vector<int>& kids) {
+	for (int p = forest[id].pack; p != -1; p = packs[p].next) {
+		if (packs[p].cnt == kids.size() && equal(kids.begin(), kids.end(), sppf_kids.begin() + packs[p].kid))
+			return;
+	}
+	sppf_pack pk;
+	pk.next = forest[id].pack; pk.kid = sppf_kids.size(); pk.cnt = kids.size();
+	sppf_kids.insert(sppf_kids.end(), kids.begin(), kids.end());
+	forest[id].pack = packs.size();
+	packs.push_back(pk);
+}
+/**
+ * ȡ״̬saʱȫгͻıGenerator::conflictsȡ.
+ * 
+ * \param s
+ * \param a
+ * \param acts
+ */
+void LRparser::glr_actions(int s, int a, vector<entry>& acts) {
+	acts.clear();
+	auto it = g.conflicts.find(s * g.ncol + a);
+	if (it != g.conflicts.end())
+		acts = it->second;
+	else if (g.slrtable[s][a].type != -1)
+		acts.push_back(g.slrtable[s][a]);
+}
+/**
+ * GSSvleftߣ¼ÿ·յͱϵSPPF㣨ң
+ * first_linkΪ-1ʱһֻ.
+ * 
+ * \param v
+ * \param left
+ * \param first_link
+ * \param labels
+ * \param ends
+ */
+void LRparser::glr_paths(int v, int left, int first_link, vector<int>& labels, vector< pair<int, vector<int>>>& ends) {
+	if (left == 0) {
+		ends.push_back(make_pair(v, vector<int>(labels.rbegin(), labels.rend())));
+		return;
+	}
+	for (int k = 0; k < gss[v].links.size(); k++) {
+		if (first_link != -1 && k != first_link)
+			continue;
+		gss_link l = gss[v].links[k];
+		labels.push_back(l.label);
+		glr_paths(l.to, left - 1, -1, labels, ends);
+		labels.pop_back();
+	}
+}
+/**
+ * GLRõѹ﷨ɭ֣ظ±꣬﷨ʱ-1.
+ * driveȷԵķslrtableгͻıflat-1
+ * ûͻʱͨLRһ죻ͻʱѵʱ״̬ջתһGSS
+ * tokenʼͼṹջͬʱж.
+ * ÿλȫԼͳһƽеGSSһʱ
+ * ¼һнķǿչԼFarshi֤©±ߵ·.
+ * GLRʹδoptimize_tableı.
+ * 
+ * \param input_string
+ * \return 
+ */
+int LRparser::glr_parse(string input_string) {
+	LexAnalyzer lex(g);
+	lex.execute(input_string);
+	tokens.swap(lex.res);
+	vector<int> syms;
+	syms.reserve(tokens.size() + 1);
+	for (auto& t : tokens)
+		syms.push_back(t.type);
+	int eof = g.eof;
+	syms.push_back(eof);
+	forest.clear(); packs.clear(); sppf_kids.clear(); gss.clear();
+
+	int cur = 0;	///Ѿƽtoken
+	auto shift = [&](int i) {
+		cur = i + 1;
+		return new_sppf(syms[i], i, i + 1, nullptr, 0);
+	};
+	auto reduce = [&](int pid, int* rhs, int len) {
+		int start = len > 0 ? forest[rhs[0]].start : cur;
+		return new_sppf(g.lhs[pid], start, cur, rhs, len);
+	};
+	vector<int> values;
+	int k = drive(syms, values, shift, reduce);
+	if (k == -1)
+		return values[1];
+
+	///ȷԷ״̬ջתGSSǰλϵSPPFǼԱ㹲
+	map< pair<int, int>, int> at_span;	///ǰλ(, )ӦSPPF
+	for (int j = 0; j <= fast_top; j++) {
+		gss_node nd;
+		nd.state = fast_state[j];
+		nd.pos = (j == 0) ? 0 : forest[values[j]].end;
+		if (j > 0) {
+			nd.links.push_back(gss_link{ j - 1, values[j] });
+			if (forest[values[j]].end == k && forest[values[j]].pack != -1)
+				at_span[make_pair(forest[values[j]].sym, forest[values[j]].start)] = values[j];
 		}
-		cout << "=> \n";
-		for (int j = 0; j < output.size(); j++)
-			cout << output[j] << ' ';
-		cout << s;
+		gss.push_back(nd);
 	}
+	vector<int> frontier(1, fast_top);
+	vector<int> at_state(g.slrtable.size(), -1);	///״̬ڵǰӦGSS
+	at_state[gss[fast_top].state] = fast_top;
+	///ĹԼ㣬ʽһ޶ıߣ-1Ϊޣ
+	struct glr_red { int v; int pid; int link; };
+	deque<glr_red> todo;
+	vector<entry> acts;
+	vector<int> labels;
+	vector< pair<int, vector<int>>> ends;
+	int root = -1;
+	for (int i = k; i < syms.size(); i++) {
+		int a = syms[i];
+		todo.clear();
+		for (auto v : frontier) {
+			glr_actions(gss[v].state, a, acts);
+			for (auto& en : acts) {
+				if (en.type == REDUCE)
+					todo.push_back(glr_red{ v, en.num, -1 });
+			}
+		}
+		while (!todo.empty()) {
+			glr_red r = todo.front();
+			todo.pop_front();
+			int lhs = g.lhs[r.pid];
+			ends.clear();
+			glr_paths(r.v, g.rlen[r.pid], r.link, labels, ends);
+			for (auto& pe : ends) {
+				int w = pe.first;
+				auto key = make_pair(lhs, gss[w].pos);
+				auto it = at_span.find(key);
+				int sp;
+				if (it == at_span.end()) {
+					sp = new_sppf(lhs, gss[w].pos, i, pe.second.data(), pe.second.size());
+					at_span[key] = sp;
+				}
+				else {
+					sp = it->second;
+					add_pack(sp, pe.second);
+				}
+				entry go = g.slrtable[gss[w].state][lhs];
+				if (go.type == ACC && a == eof) {
+					root = sp;
+					continue;
+				}
+				int u = at_state[go.num];
+				if (u == -1) {
+					gss_node nd;
+					nd.state = go.num;
+					nd.pos = i;
+					nd.links.push_back(gss_link{ w, sp });
+					gss.push_back(nd);
+					u = gss.size() - 1;
+					at_state[go.num] = u;
+					frontier.push_back(u);
+					glr_actions(go.num, a, acts);
+					for (auto& en : acts) {
+						if (en.type == REDUCE)
+							todo.push_back(glr_red{ u, en.num, -1 });
+					}
+					continue;
+				}
+				bool found = false;
+				for (auto& l : gss[u].links) {
+					if (l.to == w)
+						found = true;
+				}
+				if (found)
+					continue;
+				gss[u].links.push_back(gss_link{ w, sp });
+				for (auto v : frontier) {
+					glr_actions(gss[v].state, a, acts);
+					for (auto& en : acts) {
+						if (en.type == REDUCE && g.rlen[en.num] > 0)
+							todo.push_back(glr_red{ v, en.num, v == u ? (int)gss[u].links.size() - 1 : -1 });
+					}
+				}
+			}
+		}
+		if (a == eof)
+			break;
+		int leaf = new_sppf(a, i, i + 1, nullptr, 0);
+		vector<int> next;
+		vector<int> next_state;
+		for (auto v : frontier) {
+			glr_actions(gss[v].state, a, acts);
+			for (auto& en : acts) {
+				if (en.type != SHIFT)
+					continue;
+				int u = -1;
+				for (auto x : next) {
+					if (gss[x].state == en.num)
+						u = x;
+				}
+				if (u == -1) {
+					gss_node nd;
+					nd.state = en.num;
+					nd.pos = i + 1;
+					gss.push_back(nd);
+					u = gss.size() - 1;
+					next.push_back(u);
+				}
+				gss[u].links.push_back(gss_link{ v, leaf });
+			}
+		}
+		for (auto v : frontier)
+			at_state[gss[v].state] = -1;
+		frontier.swap(next);
+		for (auto v : frontier)
+			at_state[gss[v].state] = v;
+		at_span.clear();
+		if (frontier.empty())
+			return -1;
+	}
+	return root;
+}
+
+double LRparser::count_from(int id, vector<double>& memo) {
+	if (forest[id].pack == -1)
+		return 1;
+	if (memo[id] >= 0)
+		return memo[id];
+	double total = 0;
+	for (int p = forest[id].pack; p != -1; p = packs[p].next) {
+		double ways = 1;
+		for (int j = 0; j < packs[p].cnt; j++)
+			ways *= count_from(sppf_kids[packs[p].kid + j], memo);
+		total += ways;
+	}
+	memo[id] = total;
+	return total;
+}
+/**
+ * ͳSPPFдrootʼһٿ﷨1ʾû.
+ * 
+ * \param root
+ * \return 
+ */
+double LRparser::count_trees(int root) {
+	vector<double> memo(forest.size(), -1);
+	return root == -1 ? 0 : count_from(root, memo);
+}
+/**
+ * ӡrootɴÿSPPFһΣ
+ * "#id  [start,end) -> "Ƶ֮" | "ֿսֱӴӡtoken.
+ * 
+ * \param root
+ */
+void LRparser::show_forest(int root) {
+	if (root == -1)
+		return;
+	vector<string> name(g.ncol);
+	for (auto& p : g.sid)
+		name[p.second] = p.first;
+	vector<bool> seen(forest.size(), false);
+	vector<int> stack(1, root);
+	seen[root] = true;
+	while (!stack.empty()) {
+		int id = stack.back();
+		stack.pop_back();
+		cout << '#' << id << ' ' << name[forest[id].sym] << " [" << forest[id].start << ',' << forest[id].end << ") ->";
+		for (int p = forest[id].pack; p != -1; p = packs[p].next) {
+			if (p != forest[id].pack)
+				cout << " |";
+			for (int j = 0; j < packs[p].cnt; j++) {
+				int c = sppf_kids[packs[p].kid + j];
+				if (forest[c].pack == -1)
+					cout << ' ' << tokens[forest[c].start].str;
+				else {
+					cout << " #" << c;
+					if (!seen[c]) {
+						seen[c] = true;
+						stack.push_back(c);
+					}
+				}
+			}
+		}
+		cout << endl;
+	}
+}
+/**
+ * arithexprprime/multexprprimeҵݹдϵĶԪ.
+ * 
+ * \param left Ѿõ
+ * \param prime  op X prime ߿յĽڵ
+ * \return 
+ */
+ast_node* LRparser::binop_chain(ast_node* left, cst_node* prime) {
+	while (prime->cnt == 3) {
+		ast_node* n = arena.make<ast_node>();
+		n->kind = AST_BINOP;
+		n->tok = prime->kids[0]->tok;
+		n->a = left;
+		n->b = collapse(prime->kids[1]);
+		left = n;
+		prime = prime->kids[2];
+	}
+	return left;
+}
+/**
+ * Ѿ﷨ѹɳ﷨
+ * ȥֻһӵм㡢źͷָstmtsҵݹչ
+ * ½ڵͬarena.
+ * 
+ * \param root
+ * \return 
+ */
+ast_node* LRparser::build_ast(cst_node* root) {
+	if (prod_kind.empty()) {
+		map<string, int> kind = { {"compoundstmt", AST_BLOCK}, {"assgstmt", AST_ASSIGN}, {"ifstmt", AST_IF},
+			{"whilestmt", AST_WHILE}, {"boolexpr", AST_BINOP}, {"arithexpr", AST_ID + 1}, {"multexpr", AST_ID + 1} };
+		for (auto& p : g.productions)
+			prod_kind.push_back(kind.count(p[0]) ? kind[p[0]] : -1);
+	}
+	return collapse(root);
+}
+
+ast_node* LRparser::collapse(cst_node* n) {
+	while (n->pid != -1 && n->cnt == 1)
+		n = n->kids[0];
+	if (n->pid != -1 && prod_kind[n->pid] == AST_ID + 1)
+		return binop_chain(collapse(n->kids[0]), n->kids[1]);
+	if (n->pid != -1 && prod_kind[n->pid] == -1 && n->cnt == 3)
+		return collapse(n->kids[1]);	///simpleexpr -> ( arithexpr )
+	ast_node* res = arena.make<ast_node>();
+	res->tok = -1;
+	if (n->pid == -1) {
+		///strԴеԭģսֱʶͳ
+		res->kind = tokens[n->tok].type == g.ident ? AST_ID : AST_LITERAL;
+		res->tok = n->tok;
+		return res;
+	}
+	res->kind = prod_kind[n->pid];
+	switch (res->kind) {
+	case AST_BLOCK: {
+		ast_node** tail = &res->a;
+		for (cst_node* st = n->kids[1]; st->cnt == 2; st = st->kids[1]) {
+			*tail = collapse(st->kids[0]);
+			tail = &(*tail)->next;
+		}
+		break;
+	}
+	case AST_ASSIGN:
+		res->tok = n->kids[0]->tok;
+		res->a = collapse(n->kids[2]);
+		break;
+	case AST_IF:
+		res->a = collapse(n->kids[2]);
+		res->b = collapse(n->kids[5]);
+		res->c = collapse(n->kids[7]);
+		break;
+	case AST_WHILE:
+		res->a = collapse(n->kids[2]);
+		res->b = collapse(n->kids[4]);
+		break;
+	case AST_BINOP: {
+		cst_node* op = n->kids[1];
+		while (op->pid != -1)
+			op = op->kids[0];
+		res->tok = op->tok;
+		res->a = collapse(n->kids[0]);
+		res->b = collapse(n->kids[2]);
+		break;
+	}
+	}
+	return res;
+}
+/**
+ * űʽʽӡ﷨.
+ * 
+ * \param n
+ */
+void LRparser::show_ast(ast_node* n) {
+	if (n == nullptr)
+		return;
+	switch (n->kind) {
+	case AST_BLOCK:
+		cout << "{ ";
+		for (ast_node* st = n->a; st != nullptr; st = st->next) {
+			show_ast(st);
+			cout << ' ';
+		}
+		cout << '}';
+		break;
+	case AST_ASSIGN:
+		cout << "(= " << tokens[n->tok].str << ' ';
+		show_ast(n->a);
+		cout << ')';
+		break;
+	case AST_IF:
+	case AST_WHILE:
+		cout << (n->kind == AST_IF ? "(if " : "(while ");
+		show_ast(n->a);
+		cout << ' ';
+		show_ast(n->b);
+		if (n->c != nullptr) {
+			cout << ' ';
+			show_ast(n->c);
+		}
+		cout << ')';
+		break;
+	case AST_BINOP:
+		cout << '(' << tokens[n->tok].str << ' ';
+		show_ast(n->a);
+		cout << ' ';
+		show_ast(n->b);
+		cout << ')';
+		break;
+	default:
+		cout << tokens[n->tok].str;
+	}
+}
+/**
+ * 뵥Ԫһͷȫ﷨ڵ.
+ * 
+ */
+void LRparser::free_tree() {
+	arena.reset();
+	spare.clear();
+	finger.clear();
+}
+/**
+ * ѻд׼.
+ * 
+ * \param buf
+ */
+void flush_buffer(string& buf) {
+	cout.write(buf.data(), buf.size());
+	buf.clear();
+}
+/**
+ * չʾ﷨Ľ
+ * طopõƵδչĲ÷űŵջ棬
+ * Ѿȷս׺дһԤóȵ飬ÿζѺ׺帴һ飬
+ * дܹһдʱȳ.
+ * ÿһԼ󲿱ǵǰ͵ҷսõս.
+ * optimize_tableƹĵʽԼopУҷսһ󲿲ͬʱ
+ * صʽȱٵĲ裺һҲԵǰλõtokenβʱչһ󲿣
+ * tokenҷսʽֱƳģչ.
+ * ʱopһƵʱֻûдȴ޷طʱ
+ * feedtokensû룩˵ԭ򲢸Ϊʽid.
+ * compactΪtrueʱֻʽidУʱ͹Լ.
+ * 
+ * \param compact
+ */
+void LRparser::show(bool compact) {
+	bool had_errors = e.report();
+	string buf;
+	if (compact) {
+		for (int i = op.size() - 1; i >= 0; i--) {
+			buf += to_string(op[i].num);
+			buf += (i == 0) ? '\n' : ' ';
+		}
+		flush_buffer(buf);
+		return;
+	}
+	vector<string> name(g.ncol);
+	vector<bool> is_term(g.ncol, false);
+	for (auto& p : g.sid) {
+		name[p.second] = (p.first == "E") ? "" : p.first + " ";
+		is_term[p.second] = g.term.count(p.first) > 0;
+	}
+	vector< vector<int>> rhs;
+	for (auto& p : g.productions) {
+		vector<int> r;
+		for (int j = 1; j < p.size(); j++)
+			r.push_back(g.sid[p[j]]);
+		rhs.push_back(r);
+	}
+	int eps = g.sid["E"];
+	///units[A]A -> XĲʽ
+	vector< vector<int>> units(g.ncol);
+	for (int p = 0; p < rhs.size(); p++) {
+		if (rhs[p].size() == 1 && rhs[p][0] != eps)
+			units[g.lhs[p]].push_back(p);
+	}
+	///fromصʽto̵ĲʽУʱΪ
+	auto chain = [&](int from, int to) {
+		vector<int> via(g.ncol, -2);
+		deque<int> q;
+		via[from] = -1;
+		q.push_back(from);
+		while (!q.empty() && via[to] == -2) {
+			int a = q.front();
+			q.pop_front();
+			for (auto p : units[a]) {
+				if (via[rhs[p][0]] == -2) {
+					via[rhs[p][0]] = p;
+					q.push_back(rhs[p][0]);
+				}
+			}
+		}
+		vector<int> res;
+		for (int x = to; via[x] >= 0; x = g.lhs[via[x]])
+			res.insert(res.begin(), via[x]);
+		return res;
+	};
+	///last[X][t]ʾXƳĴtβnul[X]ʾXƳմ
+	vector<char> nul(g.ncol, 0);
+	vector< vector<char>> last(g.ncol, vector<char>(g.ncol, 0));
+	nul[eps] = 1;
+	for (int x = 0; x < g.ncol; x++) {
+		if (is_term[x] && x != eps)
+			last[x][x] = 1;
+	}
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (int p = 0; p < rhs.size(); p++) {
+			int a = g.lhs[p];
+			bool all = true;
+			for (int j = rhs[p].size() - 1; j >= 0 && all; j--) {
+				int x = rhs[p][j];
+				for (int t = 0; t < g.ncol; t++) {
+					if (last[x][t] && !last[a][t])
+						last[a][t] = changed = true;
+				}
+				all = nul[x];
+			}
+			if (all && !nul[a])
+				nul[a] = changed = true;
+		}
+	}
+	///ʽpҲܷtβҲΪʱҲܣ
+	auto fits = [&](int p, int t) {
+		for (int j = rhs[p].size() - 1; j >= 0; j--) {
+			if (last[rhs[p][j]][t])
+				return true;
+			if (!nul[rhs[p][j]])
+				return false;
+		}
+		return true;
+	};
+	vector<int> steps;	///ȫƵƵ˳еĲʽid
+	vector<int> form;	///ҷսߵĲ
+	int k = (int)tokens.size() - 1;	///ûгں׺еһtoken
+	auto expand = [&](int pid) {
+		steps.push_back(pid);
+		form.pop_back();
+		for (auto x : rhs[pid])
+			form.push_back(x);
+		while (!form.empty() && is_term[form.back()]) {
+			if (form.back() != eps)
+				k--;
+			form.pop_back();
+		}
+	};
+	bool ok = true;
+	form.push_back(g.sid["program"]);
+	for (int i = op.size() - 1; i >= -1 && ok; i--) {
+		int want = i >= 0 ? g.lhs[op[i].num] : -1;
+		while (ok && !form.empty()) {
+			///ǰλõtokenɵʽֱƳһӦߵĹԼ
+			vector<int> tc;
+			int t = k >= 0 ? tokens[k].type : -1;
+			if (t >= 0 && t < g.ncol)
+				tc = chain(form.back(), t);
+			if (want != -1 && (tc.empty() || fits(op[i].num, t))) {
+				if (form.back() == want)
+					break;
+				vector<int> c = chain(form.back(), want);
+				if (!c.empty()) {
+					for (auto p : c)
+						expand(p);
+					continue;
+				}
+			}
+			ok = !tc.empty();
+			for (auto p : tc)
+				expand(p);
+		}
+		if (i >= 0) {
+			ok = ok && !form.empty();
+			if (ok)
+				expand(op[i].num);
+		}
+	}
+	if (!ok || !form.empty()) {
+		if (!had_errors) {
+			buf = "޷ԭƵƵ˳ʽţ\n";
+			for (int i = op.size() - 1; i >= 0; i--) {
+				buf += to_string(op[i].num);
+				buf += (i == 0) ? '\n' : ' ';
+			}
+			flush_buffer(buf);
+		}
+		return;
+	}
+	size_t total = 0;
+	for (auto p : steps) {
+		for (auto x : rhs[p]) {
+			if (is_term[x])
+				total += name[x].size();
+		}
+	}
+	string suffix(total, ' ');	///Ѿȷս׺ռ[pos, total)
+	size_t pos = total;
+	form.push_back(g.sid["program"]);
+	buf = "program ";
+	for (auto p : steps) {
+		form.pop_back();
+		for (auto x : rhs[p])
+			form.push_back(x);
+		while (!form.empty() && is_term[form.back()]) {
+			const string& w = name[form.back()];
+			pos -= w.size();
+			suffix.replace(pos, w.size(), w);
+			form.pop_back();
+		}
+		buf += "=> \n";
+		for (auto x : form)
+			buf += name[x];
+		buf.append(suffix, pos, total - pos);
+		if (buf.size() >= (1 << 16))
+			flush_buffer(buf);
+	}
+	flush_buffer(buf);
+}
+
+/**
+ * ֱԭʼĺͺSLR tableͬһ룬
+ * ӡÿtokenƽִеĹԼԼʡĹԼ.
+ * 
+ * \param input_string
+ * \param keep
+ */
+void LRparser::report_saving(string input_string, set<int> keep) {
+	LRparser plain, opt;
+	plain.init_table(rules);
+	opt.init_table(rules);
+	table_stats stats = opt.optimize_table(keep);
+	plain.execute(input_string);
+	opt.execute(input_string);
+	double n = plain.tokens.empty() ? 1 : plain.tokens.size();
+	cout << "states: " << plain.g.canonical_collection.size() << " -> " << stats.live
+		<< " (unit bypass " << stats.unit_removed << ", merged " << stats.merged
+		<< ", default reduce " << stats.defred << ")" << endl;
+	cout << "reductions per token: " << plain.reduce_cnt / n << " -> " << opt.reduce_cnt / n
+		<< ", saved " << (plain.reduce_cnt - opt.reduce_cnt) / n << endl;
 }
 
 void Analysis()
@@ -9,6 +9,17 @@
 #include <vector>
 #include <set>
 #include <deque>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <array>
+///x86-64Ĭñ룬TSP_NO_JITԹص
+#if !defined(TSP_NO_JIT) && defined(__x86_64__) && !defined(_WIN32)
+#define TSP_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 using namespace std;
 /* Ҫ޸׼뺯 */
 void read_prog(string& prog)
@@ -23,13 +34,21 @@ void read_prog(string& prog)
 /*  */
 
 ///errorö
-enum { DIVIDE_BY_ZERO, REAL_TO_INT, INT_TO_NUM, DELIMETRE, UNDECLARED_ID, UNDECLARED_ID_ASSIGN, UNKONW };
+enum { DIVIDE_BY_ZERO, REAL_TO_INT, INT_TO_NUM, DELIMETRE, UNDECLARED_ID, UNDECLARED_ID_ASSIGN, UNKONW,
+	MISSING_SYMBOL, EXTRA_SYMBOL, REPLACED_SYMBOL, EARLY_EOF, LOOP_LIMIT };
 ///IDtokenö
 enum { REAL, INT,ID };
-///ö
-enum { EMPTY,ASSIGN, BOOL, ARITH, IF, DECLARE ,ARITHPRIME,INSTANT,IDVALUE,BOOLOP};
+///öͣFOLDprimeβĿղʽ
+enum { EMPTY,ASSIGN, BOOL, ARITH, IF, DECLARE ,ARITHPRIME,INSTANT,IDVALUE,BOOLOP,FOLD,PASS,STMTS,BLOCK,PROGRAM,WHILE};
 ///LRparserö
 enum { SHIFT, REDUCE, GOTO, ACC };
+///﷨
+enum { AST_BLOCK, AST_ASSIGN, AST_IF, AST_BINOP, AST_LITERAL, AST_ID, AST_DECL, AST_WHILE };
+///Ԫ
+enum { OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ };
+///ֽĲ룬I㣬Fʵ㣬I_JNxxڱȽϲʱתI_LOOPǼѭر
+enum { I_MOVE, I_IADD, I_ISUB, I_IMUL, I_IDIV, I_FADD, I_FSUB, I_FMUL, I_FDIV, I_ITOF, I_FTOI,
+	I_JNILT, I_JNIGT, I_JNILE, I_JNIGE, I_JNIEQ, I_JNFLT, I_JNFGT, I_JNFLE, I_JNFGE, I_JNFEQ, I_JMP, I_HALT, I_LOOP };
 
 struct token {
 	string str;
@@ -37,6 +56,8 @@ struct token {
 	string name;
 	int type;
 	int line_num;
+	int sym = -1;	///ӦսGenerator::sidеı
+	int ast = -1;	///ֵջʱԼõ﷨
 
 	token() {}
 	token(string s, double v, int t, int ln) {
@@ -54,23 +75,14 @@ struct entry {
 	entry(int t, int n) { type = t; num = n; }
 };
 
-struct expr {
-	entry op;
-	vector<token> tokens;
-
-	expr(){}
-	expr(entry o, vector<token> ts) {
-		op = o; tokens = ts;
-	}
-};
-
 struct error {
 	int type;
 	int line_num;
+	string word;	///﷨漰ķ
 
 	error() {}
-	error(int t, int ln) {
-		type = t; line_num = ln;
+	error(int t, int ln, string w = "") {
+		type = t; line_num = ln; word = w;
 	}
 };
 
@@ -80,6 +92,79 @@ struct item {
 	item() {}
 	item(int p, int i) { pid = p; idx = i; }
 };
+/**
+ * õ﷨㣬ȫLRparser::treeУ±껥.
+ * aǵһ䣬bǵһnext
+ * ֵaұߵıʽifabcthen֧else֧whileabѭ壻
+ * ԪabҲ.
+ */
+struct ast_node {
+	int kind;
+	int op = -1;	///AST_BINOP
+	int type = INT;	///ʽͣAST_DECL
+	double value = 0;	///AST_LITERALֵAST_DECLĳֵ
+	long long ival = 0;	///intֵ
+	string name;	///AST_IDAST_ASSIGNAST_DECLıʶ
+	int slot = -1;	///resolve󶨵ıλҲǼĴ
+	int line_num;
+	int a = -1, b = -1, c = -1, next = -1;	///AST_DECLaǳֵ
+
+	ast_node() {}
+	ast_node(int k, int ln) { kind = k; line_num = ln; }
+};
+/**
+ * ַļĴָaĿļĴתָĿλãbcԴĴ.
+ */
+struct insn {
+	int op;
+	int a, b, c;
+
+	insn() {}
+	insn(int o, int x, int y, int z) { op = o; a = x; b = y; c = z; }
+};
+/**
+ * Ĵintirealf.
+ */
+union reg {
+	long long i;
+	double f;
+
+	reg() { i = 0; }
+};
+/**
+ * ͵ıֵPreparedProgram::runĳֵͽ
+ * intdouble2^53ֵҲᶪʧ.
+ */
+struct typed_value {
+	int type;	///INTREAL
+	reg v;
+
+	typed_value() { type = INT; }
+	typed_value(int x) { type = INT; v.i = x; }
+	typed_value(long long x) { type = INT; v.i = x; }
+	typed_value(double x) { type = REAL; v.f = x; }
+	double real() const { return type == INT ? (double)v.i : v.f; }
+};
+///intrealԭһdouble
+ostream& operator<<(ostream& os, const typed_value& x) {
+	if (x.type == INT)
+		return os << x.v.i;
+	return os << x.v.f;
+}
+/**
+ * õֽ.
+ * ĴǱʱֵinitǰĴĳֵ
+ * initоѾźãֱָӰǵԴĴʹãҪȡָ.
+ */
+struct bytecode {
+	vector<insn> code;
+	vector<int> lines;	///ÿָӦԴк
+	vector<string> names;	///±ǼĴţǰndeclı
+	vector<int> types;	///
+	vector<reg> init;
+	int ndecl = 0;
+	long long max_iters = 0;	///һִI_LOOPתĴ
+};
 
 vector<token> split_word(string s);
 /**
@@ -90,11 +175,12 @@ private:
 	vector<error> errors;
 public:
 	bool report();
-	void add(int error, int ln);
+	bool empty() const { return errors.empty(); }
+	void add(int error, int ln, string word = "");
 };
 
-void ErrorHandler::add(int etype, int ln) {
-	errors.push_back(error(etype, ln));
+void ErrorHandler::add(int etype, int ln, string word) {
+	errors.push_back(error(etype, ln, word));
 }
 
 bool ErrorHandler::report() {
@@ -102,6 +188,8 @@ bool ErrorHandler::report() {
 		return false;
 	}
 	else {
+		///﷨󡢱ڴڴǷּμģкŻԴ˳
+		stable_sort(errors.begin(), errors.end(), [](const error& x, const error& y) { return x.line_num < y.line_num; });
 		for (auto e : errors) {
 			cout << "error message:line " << e.line_num << ",";
 			switch (e.type) {
@@ -117,6 +205,21 @@ bool ErrorHandler::report() {
 			case UNDECLARED_ID_ASSIGN:
 				cout << "cannot assign value to undeclared id" << endl;
 				break;
+			case MISSING_SYMBOL:
+				cout << "syntax error, missing \"" << e.word << "\"" << endl;
+				break;
+			case EXTRA_SYMBOL:
+				cout << "syntax error, unexpected \"" << e.word << "\"" << endl;
+				break;
+			case REPLACED_SYMBOL:
+				cout << "syntax error, " << e.word << endl;
+				break;
+			case EARLY_EOF:
+				cout << "syntax error, unexpected end of input" << endl;
+				break;
+			case LOOP_LIMIT:
+				cout << "too many loop iterations" << endl;
+				break;
 			default:
 				cout << "unkown error" << endl;
 			}
@@ -282,20 +385,21 @@ void Generator::generate_follow() {
 			pid++;
 			bool end_null = true;
 			for (int j = ps.size() - 1; j >= 2; j--) {
-				if (nonterm.count(ps[j - 1])) {
-
-					if (term.count(ps[j])) {
-						follow[sid[ps[j - 1]]].insert(ps[j]);
+				///ķսΪʱ󿴣ֱս߲Ϊյķ
+				for (int k = j; nonterm.count(ps[j - 1]) && k < ps.size(); k++) {
+					if (term.count(ps[k])) {
+						follow[sid[ps[j - 1]]].insert(ps[k]);
 						if (nullable[ps[j - 1]])
-							table[sid[ps[j - 1]]][sid[ps[j]]] = null_pid[ps[j - 1]];
+							table[sid[ps[j - 1]]][sid[ps[k]]] = null_pid[ps[j - 1]];
+						break;
 					}
-					else {
-						for (auto f : first[sid[ps[j]]]) {
-							follow[sid[ps[j - 1]]].insert(f);
-							if (nullable[ps[j - 1]])
-								table[sid[ps[j - 1]]][sid[f]] = null_pid[ps[j - 1]];
-						}
+					for (auto f : first[sid[ps[k]]]) {
+						follow[sid[ps[j - 1]]].insert(f);
+						if (nullable[ps[j - 1]])
+							table[sid[ps[j - 1]]][sid[f]] = null_pid[ps[j - 1]];
 					}
+					if (!nullable[ps[k]])
+						break;
 				}
 				if (nonterm.count(ps[j]) && end_null) {
 					for (auto f : follow[sid[ps[0]]]) {
@@ -489,238 +593,1876 @@ void Generator::generate_SLRtable() {
 	generate_canonical_collection();
 }
 
-class  LRparser {
+/**
+ * жַ͵ĺLexicalAnalysis.hͬ.
+ *
+ * \param c
+ * \return
+ */
+bool isDigit(char c) {
+	if (c >= '0' && c <= '9')
+		return true;
+	return false;
+}
+bool isAlpha(char c) {
+	if (c >= 'a' && c <= 'z')
+		return true;
+	if (c >= 'A' && c <= 'Z')
+		return true;
+	if (c == '_')
+		return true;
+	return false;
+}
+/**
+ * ߵߵн绷λ
+ * headֻдtailֻдacquire/releaseԣҪ
+ * ˮ߸׶֮䰴tokenexpr˻˾óCPUȴ.
+ */
+template <class T>
+class RingBuffer {
 private:
-	vector<token> tokens;
-	deque<token> input;
-	deque<token> work;
-	deque<int> state;
-	vector<entry> op;
-	deque<string> output;
-	map<int, int> rtype;
-	ErrorHandler e;
-	vector<expr> exprs;
-	map<string, double> id_value;
-	map<string, int> id_type;
-	Generator g;
+	vector<T> buf;
+	size_t mask;
+	alignas(64) atomic<size_t> head;	///һҪλ
+	alignas(64) atomic<size_t> tail;	///һҪдλ
 public:
-	void init_table(string raw_input);
-	vector<entry> execute(string input);
-	void show();
-	vector<token> split_word(string s);
-	token str_to_token(string s,int ln);
-	void translate();
+	RingBuffer(size_t cap) {
+		size_t n = 1;
+		while (n < cap)
+			n <<= 1;
+		buf.resize(n);
+		mask = n - 1;
+		head.store(0);
+		tail.store(0);
+	}
+	/**
+	 * ԷһԪأɹʱv߲.
+	 */
+	bool try_push(T& v) {
+		size_t t = tail.load(memory_order_relaxed);
+		if (t - head.load(memory_order_acquire) > mask)
+			return false;
+		buf[t & mask] = move(v);
+		v.clear();
+		tail.store(t + 1, memory_order_release);
+		return true;
+	}
+	bool try_pop(T& v) {
+		size_t h = head.load(memory_order_relaxed);
+		if (h == tail.load(memory_order_acquire))
+			return false;
+		v = move(buf[h & mask]);
+		head.store(h + 1, memory_order_release);
+		return true;
+	}
+	void push(T& v) {
+		while (!try_push(v))
+			this_thread::yield();
+	}
+	void pop(T& v) {
+		while (!try_pop(v))
+			this_thread::yield();
+	}
 };
 
-void LRparser::init_table(string raw_input) {
-	g = Generator(raw_input);
-	g.generate_dic();
-	g.generate_first();
-	g.generate_follow();
-	g.generate_canonical_collection();
-
-	rtype[4] = DECLARE; rtype[5] = DECLARE; rtype[12] = IF; rtype[13] = ASSIGN; rtype[14] = BOOL; rtype[20] = ARITH;
-	rtype[21] = ARITHPRIME; rtype[22] = ARITHPRIME; rtype[24] = ARITH; rtype[25] = ARITHPRIME; rtype[26] = ARITHPRIME;
-	rtype[28] = IDVALUE; rtype[29] = INSTANT; rtype[30] = INSTANT; rtype[31] = ARITH;
-	rtype[15] = BOOLOP; rtype[16] = BOOLOP; rtype[17] = BOOLOP; rtype[18] = BOOLOP; rtype[19] = BOOLOP;
-}
 /**
- * תɴtypevalueԼкϢtokenĺ
- * Ҫǻȡ͵valueԼʶתΪnameID token.
- * 
- * \param word
- * \param ln
- * \return 
+ * ʵתȡΧNaNʱõ0.
+ *
+ * \param v
+ * \return
  */
-token LRparser::str_to_token(string word, int ln) {
-	if (g.term.count(word))
-		return token(word, -1, -1, ln);
-	else {
-		if (word[0] >= '0'&&word[0] <= '9') {
-			vector<double> res;
-			int dot_pos = word.length();
-			for (int i = 0; i < word.length(); i++) {
-				if (word[i] == '.')
-					dot_pos = i;
-			}
-			double temp = 0;
-			double mult = 1;
-			for (int i = dot_pos - 1; i >= 0; i--) {
-				temp += (word[i] - '0')*mult;
-				mult *= 10;
-			}
-			res.push_back(temp);
-			temp = 0;
-			mult = 0.1;
-			if (dot_pos != word.length()) {
-				for (int i = dot_pos + 1; i < word.length(); i++) {
-					temp += (word[i] - '0')*mult;
-					mult /= 10;
-				}
-				res.push_back(temp);
-			}
-			int ntype = (res.size() == 1) ? INT : REAL;
-			if (ntype == REAL)
-				return token("REALNUM", res[0] + res[1], REAL, ln);
-			else
-				return token("INTNUM", res[0], INT, ln);
-		}
-		else
-			return token("ID", word, ID, ln);
-	}
+inline long long real_to_int(double v) {
+	return v > -9.2e18 && v < 9.2e18 ? (long long)v : 0;
 }
 /**
- * ִʺ
- * ַָɴкϢtoken,
- * жtypevalueԱʶתΪnameID token.
- * 
- * \param s
- * \return 
+ * ִbytecodeGCC/Clangcomputed gotothreaded dispatch
+ * ÿָʱֱһָĴ룬˻صswitch.
+ * ʵòָͬڱʱѾȷʱж.
+ * ʱ״̬ڼĴVMbytecodeֻ.
  */
-vector<token> LRparser::split_word(string s) {
-	vector<string> split_temp;
-	vector<token> split_res;
-	split_res.clear();
-	string line = "";
-	string word = "";
-	for (auto c : s) {
-		if (c == '\n') {
-			if(line!="")
-				split_temp.push_back(line);
-			line = "";
+class VM {
+public:
+	vector<int> div_zero;	///Ϊ0ָڵУͬһֻһ
+	int overrun = -1;	///ѭʱI_LOOPڵУ-1ʾ
+	void run(const bytecode& p, reg* r);
+	void add_div_zero(int ln);
+};
+
+#if defined(__GNUC__)
+#define VM_CASE(x) L_##x:
+#define VM_NEXT goto *labels[(++ip)->op]
+#define VM_JUMP(t) { ip = code + (t); goto *labels[ip->op]; }
+#else
+#define VM_CASE(x) case x:
+#define VM_NEXT { ++ip; break; }
+#define VM_JUMP(t) { ip = code + (t); break; }
+#endif
+///ļӼ˰ƣз
+#define VM_IARITH(x, o) VM_CASE(x) r[ip->a].i = (long long)((unsigned long long)r[ip->b].i o (unsigned long long)r[ip->c].i); VM_NEXT;
+#define VM_JN(x, f, o) VM_CASE(x) if (!(r[ip->b].f o r[ip->c].f)) VM_JUMP(ip->a); VM_NEXT;
+/**
+ * ӵһָʼִеI_HALTrѾinitʼļĴ.
+ * 0ʱΪ0ʵ0IEEEõinfNaN¼к.
+ * I_LOOPתĴp.max_itersʱкŲ.
+ *
+ * \param p
+ * \param r
+ */
+void VM::run(const bytecode& p, reg* r) {
+	const insn* code = p.code.data();
+	const insn* ip = code;
+	long long left = p.max_iters;
+#if defined(__GNUC__)
+	static const void* labels[] = { &&L_I_MOVE, &&L_I_IADD, &&L_I_ISUB, &&L_I_IMUL, &&L_I_IDIV,
+		&&L_I_FADD, &&L_I_FSUB, &&L_I_FMUL, &&L_I_FDIV, &&L_I_ITOF, &&L_I_FTOI,
+		&&L_I_JNILT, &&L_I_JNIGT, &&L_I_JNILE, &&L_I_JNIGE, &&L_I_JNIEQ,
+		&&L_I_JNFLT, &&L_I_JNFGT, &&L_I_JNFLE, &&L_I_JNFGE, &&L_I_JNFEQ, &&L_I_JMP, &&L_I_HALT, &&L_I_LOOP };
+	goto *labels[ip->op];
+#else
+	for (;;) switch (ip->op) {
+#endif
+	VM_CASE(I_MOVE) r[ip->a] = r[ip->b]; VM_NEXT;
+	VM_IARITH(I_IADD, +)
+	VM_IARITH(I_ISUB, -)
+	VM_IARITH(I_IMUL, *)
+	VM_CASE(I_IDIV) {
+		long long y = r[ip->c].i;
+		if (y == 0) {
+			add_div_zero(p.lines[ip - code]);
+			r[ip->a].i = 0;
 		}
+		else if (y == -1)
+			r[ip->a].i = (long long)(0ULL - (unsigned long long)r[ip->b].i);
 		else
-			line += c;
+			r[ip->a].i = r[ip->b].i / y;
+		VM_NEXT;
 	}
-	if (line != "")
-		split_temp.push_back(line);
-	for (int i = 0; i < split_temp.size(); i++) {
-		word = "";
-		for (auto c : split_temp[i]) {
-			if (c == ' ') {
-				if (word != "") {
-					split_res.push_back(str_to_token(word, i + 1));
-				}
-				word = "";
-			}
-			else
-				word += c;
+	VM_CASE(I_FADD) r[ip->a].f = r[ip->b].f + r[ip->c].f; VM_NEXT;
+	VM_CASE(I_FSUB) r[ip->a].f = r[ip->b].f - r[ip->c].f; VM_NEXT;
+	VM_CASE(I_FMUL) r[ip->a].f = r[ip->b].f * r[ip->c].f; VM_NEXT;
+	VM_CASE(I_FDIV)
+		if (r[ip->c].f == 0)
+			add_div_zero(p.lines[ip - code]);
+		r[ip->a].f = r[ip->b].f / r[ip->c].f;
+		VM_NEXT;
+	VM_CASE(I_ITOF) r[ip->a].f = (double)r[ip->b].i; VM_NEXT;
+	VM_CASE(I_FTOI) r[ip->a].i = real_to_int(r[ip->b].f); VM_NEXT;
+	VM_JN(I_JNILT, i, <)
+	VM_JN(I_JNIGT, i, >)
+	VM_JN(I_JNILE, i, <=)
+	VM_JN(I_JNIGE, i, >=)
+	VM_JN(I_JNIEQ, i, ==)
+	VM_JN(I_JNFLT, f, <)
+	VM_JN(I_JNFGT, f, >)
+	VM_JN(I_JNFLE, f, <=)
+	VM_JN(I_JNFGE, f, >=)
+	VM_JN(I_JNFEQ, f, ==)
+	VM_CASE(I_JMP) VM_JUMP(ip->a);
+	VM_CASE(I_HALT) return;
+	VM_CASE(I_LOOP)
+		if (left-- == 0) {
+			overrun = p.lines[ip - code];
+			return;
 		}
-		if (word != "")
-			split_res.push_back(str_to_token(word, i + 1));
+		VM_JUMP(ip->a);
+#if !defined(__GNUC__)
 	}
-	return split_res;
+#endif
 }
-vector<token> split_word(string s) {
-	vector<string> split_temp;
-	vector<token> split_res;
-	split_res.clear();
-	string line = "";
-	string word = "";
-	for (auto c : s) {
-		if (c == '\n') {
-			if (line != "")
-				split_temp.push_back(line);
-			line = "";
-		}
-		else
-			line += c;
-	}
-	if (line != "")
-		split_temp.push_back(line);
-	for (int i = 0; i < split_temp.size(); i++) {
-		word = "";
-		for (auto c : split_temp[i]) {
-			if (c == ' ') {
-				if (word != "")
-					split_res.push_back(token(word, -1, -1, i + 1));
-				word = "";
-			}
-			else
-				word += c;
-		}
-		if (word != "")
-			split_res.push_back(token(word, -1, -1, i + 1));
-	}
-	return split_res;
+/**
+ * ¼0кţѭͬһֻᷴǵһ.
+ *
+ * \param ln
+ */
+void VM::add_div_zero(int ln) {
+	if (find(div_zero.begin(), div_zero.end(), ln) == div_zero.end())
+		div_zero.push_back(ln);
 }
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_JUMP
+#undef VM_IARITH
+#undef VM_JN
+
 /**
- * ﷨
- * նӦ룬ȷִʣ
- * dequeģջBottom-up﷨
- * 洢ÿһеĲҪreductionԹ﷨Ƶʹ.
+ * bytecodex86-64룬mmapõĿִڴ.
+ * ʱֵȻڼĴrbxָ飬r12ָ¼VMr13ʣµѭ
+ * ͨüĴʵSSE2ÿָVM::runȫͬλһ.
+ * x86-64ƽ̨TSP_NO_JITCPU֧SSE2벻ִڴʱcompilefalse
+ * ˻صVMִ.
+ */
+class NativeCode {
+public:
+	NativeCode() {}
+	NativeCode(const NativeCode&) = delete;
+	NativeCode& operator=(const NativeCode&) = delete;
+	~NativeCode();
+	bool compile(const bytecode& p);
+	void run(reg* r, VM& vm) const;
+private:
+	///ֱܳߴŲָ棬ɱ뷴VM
+	static const int max_insns = 1 << 16;
+	void* mem = nullptr;	///mmapõڴ
+	size_t size = 0;
+	void (*entry)(reg*, VM*) = nullptr;
+	vector<unsigned char> out;	///compileʱɵĻ
+	static bool supported();
+	static void div_zero(VM* vm, int ln);
+	static void loop_limit(VM* vm, int ln);
+	void put(initializer_list<int> bytes);
+	void put32(int v);
+	void put64(long long v);
+	void mem_op(initializer_list<int> opc, int r, int slot);
+	int jump8(int opc);
+	void patch8(int pos);
+	void call(void (*f)(VM*, int), int ln);
+	void epilogue();
+};
+
+NativeCode::~NativeCode() {
+#ifdef TSP_JIT
+	if (mem != nullptr)
+		munmap(mem, size);
+#endif
+}
+
+bool NativeCode::supported() {
+#if defined(TSP_JIT) && defined(__GNUC__)
+	return __builtin_cpu_supports("sse2");
+#elif defined(TSP_JIT)
+	return true;
+#else
+	return false;
+#endif
+}
+/**
+ * ڳΪ0ʱãVM::runһк.
  *
- * \param input_string
+ * \param vm
+ * \param ln
+ */
+void NativeCode::div_zero(VM* vm, int ln) {
+	vm->add_div_zero(ln);
+}
+
+void NativeCode::loop_limit(VM* vm, int ln) {
+	vm->overrun = ln;
+}
+
+void NativeCode::put(initializer_list<int> bytes) {
+	for (int b : bytes)
+		out.push_back((unsigned char)b);
+}
+
+void NativeCode::put32(int v) {
+	for (int i = 0; i < 4; i++)
+		out.push_back((unsigned char)((unsigned)v >> (8 * i)));
+}
+
+void NativeCode::put64(long long v) {
+	for (int i = 0; i < 8; i++)
+		out.push_back((unsigned char)((unsigned long long)v >> (8 * i)));
+}
+/**
+ * ɲΪĴslotָ[rbx + 8 * slot].
+ *
+ * \param opc ǰ׺Ͳ
+ * \param r ModRMregֶΣrax/xmm00rcx/xmm11
+ * \param slot
+ */
+void NativeCode::mem_op(initializer_list<int> opc, int r, int slot) {
+	put(opc);
+	out.push_back((unsigned char)(0x83 | r << 3));
+	put32(slot * 8);
+}
+/**
+ * ĿĶתƫڵλãpatch8ɵǰλ.
+ *
+ * \param opc
  * \return
  */
-vector<entry> LRparser::execute(string input_string) {
-	tokens = split_word(input_string);
-	for (int i = tokens.size() - 1; i >= 0; i--)
-		input.push_front(tokens[i]);
-	input.push_back(token("$", -1, -1, -1));
-	state.push_front(0);
+int NativeCode::jump8(int opc) {
+	put({ opc, 0 });
+	return out.size() - 1;
+}
 
-	token workhead; token inputhead; int statehead; entry curop; int curline = 1;
+void NativeCode::patch8(int pos) {
+	out[pos] = (unsigned char)(out.size() - pos - 1);
+}
+/**
+ * f(vm, ln)rbxr12r13callee-savedǰñ.
+ *
+ * \param f
+ * \param ln
+ */
+void NativeCode::call(void (*f)(VM*, int), int ln) {
+	put({ 0x4C, 0x89, 0xE7, 0xBE });	///mov rdi, r12; mov esi, ln
+	put32(ln);
+	put({ 0x48, 0xB8 });	///mov rax, f; call rax
+	put64((long long)f);
+	put({ 0xFF, 0xD0 });
+}
 
-	while (!input.empty()) {
-		statehead = state.front();
-		inputhead = input.front();
-		//cout << "line " << curline << " : " << statehead << ' ' << inputhead.str << ' ';
-		curop = g.slrtable[statehead][g.sid[inputhead.str]];
-		//cout<<curop.type<<' '<<curop.num<<endl;
-		if (curop.type == ACC)
+///pop r13; pop r12; pop rbx; ret
+void NativeCode::epilogue() {
+	put({ 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 });
+}
+/**
+ * bytecodeתȼĿָıţȫ֮ٻ.
+ *
+ * \param p
+ * \return ǷɳɹʧʱӦʹVM
+ */
+bool NativeCode::compile(const bytecode& p) {
+#ifdef TSP_JIT
+	if (entry != nullptr || !supported() || p.code.size() > max_insns)
+		return false;
+	///I_JNxxʱתȽϺõjcc
+	static const int icc[] = { 0x8D, 0x8E, 0x8F, 0x8C, 0x85 };
+	///ʵSSE2룺addsdsubsdmulsddivsd
+	static const int fop[] = { 0x58, 0x5C, 0x59, 0x5E };
+	vector<int> start(p.code.size());
+	vector<pair<int, int>> fix;
+	out.clear();
+	///push rbx; push r12; push r13; mov rbx, rdi; mov r12, rsi; mov r13, max_iterspush֮ջ16ֽڶ
+	put({ 0x53, 0x41, 0x54, 0x41, 0x55, 0x48, 0x89, 0xFB, 0x49, 0x89, 0xF4, 0x49, 0xBD });
+	put64(p.max_iters);
+	for (int i = 0; i < p.code.size(); i++) {
+		const insn& x = p.code[i];
+		start[i] = out.size();
+		switch (x.op) {
+		case I_MOVE:
+			mem_op({ 0x48, 0x8B }, 0, x.b);
+			mem_op({ 0x48, 0x89 }, 0, x.a);
+			break;
+		case I_IADD:
+		case I_ISUB:
+		case I_IMUL:
+			mem_op({ 0x48, 0x8B }, 0, x.b);
+			if (x.op == I_IADD)
+				mem_op({ 0x48, 0x03 }, 0, x.c);
+			else if (x.op == I_ISUB)
+				mem_op({ 0x48, 0x2B }, 0, x.c);
+			else
+				mem_op({ 0x48, 0x0F, 0xAF }, 0, x.c);
+			mem_op({ 0x48, 0x89 }, 0, x.a);
+			break;
+		///Ϊ0ʱ¼кţΪ0Ϊ-1ʱȡINT_MIN / -1#DE
+		case I_IDIV: {
+			mem_op({ 0x48, 0x8B }, 1, x.c);
+			put({ 0x48, 0x85, 0xC9 });
+			int nz = jump8(0x75);
+			call(&NativeCode::div_zero, p.lines[i]);
+			put({ 0x31, 0xC0 });
+			int z = jump8(0xEB);
+			patch8(nz);
+			mem_op({ 0x48, 0x8B }, 0, x.b);
+			put({ 0x48, 0x83, 0xF9, 0xFF });
+			int nm = jump8(0x75);
+			put({ 0x48, 0xF7, 0xD8 });
+			int m = jump8(0xEB);
+			patch8(nm);
+			put({ 0x48, 0x99, 0x48, 0xF7, 0xF9 });
+			patch8(z);
+			patch8(m);
+			mem_op({ 0x48, 0x89 }, 0, x.a);
 			break;
-		if (curop.type == SHIFT) {
-			work.push_front(inputhead);
-			input.pop_front();
-			state.push_front(curop.num);
 		}
-		if (curop.type == REDUCE) {
-			vector<token> ts;
-			op.push_back(curop);
-			ts.push_back(token("#",-1,-1,-1));
-			for (int i = 1; i < g.productions[curop.num].size(); i++) {
-				if (g.productions[curop.num][i] == "E")
-					continue;
-				ts.push_back(work.front());
-				work.pop_front();
-				state.pop_front();
+		case I_FADD:
+		case I_FSUB:
+		case I_FMUL:
+		case I_FDIV:
+			///0NaNʱȼ¼кţճIEEE
+			if (x.op == I_FDIV) {
+				mem_op({ 0xF2, 0x0F, 0x10 }, 1, x.c);
+				put({ 0x66, 0x0F, 0x57, 0xC0, 0x66, 0x0F, 0x2E, 0xC8 });
+				int un = jump8(0x7A);
+				int ne = jump8(0x75);
+				call(&NativeCode::div_zero, p.lines[i]);
+				patch8(un);
+				patch8(ne);
 			}
-			exprs.push_back(expr(curop, ts));
-			work.push_front(token(g.productions[curop.num][0], -1, -1, inputhead.line_num));
-			entry temp = g.slrtable[state.front()][g.sid[g.productions[curop.num][0]]];
-			//cout << state.front() << ' ' << g.productions[curop.num][0] << ' ' << temp.type << ' ' << temp.num << endl;
-			state.push_front(temp.num);
-			if (temp.type == ACC)
-				break;
+			mem_op({ 0xF2, 0x0F, 0x10 }, 0, x.b);
+			mem_op({ 0xF2, 0x0F, fop[x.op - I_FADD] }, 0, x.c);
+			mem_op({ 0xF2, 0x0F, 0x11 }, 0, x.a);
+			break;
+		case I_ITOF:
+			mem_op({ 0xF2, 0x48, 0x0F, 0x2A }, 0, x.b);
+			mem_op({ 0xF2, 0x0F, 0x11 }, 0, x.a);
+			break;
+		///real_to_intһֻ(-9.2e18, 9.2e18)֮ڲŽضϣࣨNaNõ0
+		case I_FTOI: {
+			double lo = -9.2e18, hi = 9.2e18;
+			long long bits;
+			mem_op({ 0xF2, 0x0F, 0x10 }, 0, x.b);
+			memcpy(&bits, &hi, sizeof(bits));
+			put({ 0x48, 0xB8 });
+			put64(bits);
+			put({ 0x66, 0x48, 0x0F, 0x6E, 0xC8, 0x66, 0x0F, 0x2E, 0xC8 });
+			int a = jump8(0x76);
+			memcpy(&bits, &lo, sizeof(bits));
+			put({ 0x48, 0xB8 });
+			put64(bits);
+			put({ 0x66, 0x48, 0x0F, 0x6E, 0xC8, 0x66, 0x0F, 0x2E, 0xC1 });
+			int b = jump8(0x76);
+			put({ 0xF2, 0x48, 0x0F, 0x2C, 0xC0 });
+			int done = jump8(0xEB);
+			patch8(a);
+			patch8(b);
+			put({ 0x31, 0xC0 });
+			patch8(done);
+			mem_op({ 0x48, 0x89 }, 0, x.a);
+			break;
 		}
-		if (curop.type == -1) {
-			if (inputhead.str == "REALNUM") {
-				inputhead.str = "INTNUM";
-				input.pop_front(); input.push_front(inputhead);
-				e.add(REAL_TO_INT, curline);
+		case I_JNILT:
+		case I_JNIGT:
+		case I_JNILE:
+		case I_JNIGE:
+		case I_JNIEQ:
+			mem_op({ 0x48, 0x8B }, 0, x.b);
+			mem_op({ 0x48, 0x3B }, 0, x.c);
+			put({ 0x0F, icc[x.op - I_JNILT] });
+			fix.push_back(make_pair((int)out.size(), x.a));
+			put32(0);
+			break;
+		///ucomisdNaNʱZFPFCF1СںСڵڽja/jaeжϣNaNʱ
+		case I_JNFLT:
+		case I_JNFLE:
+			mem_op({ 0xF2, 0x0F, 0x10 }, 0, x.c);
+			mem_op({ 0x66, 0x0F, 0x2E }, 0, x.b);
+			put({ 0x0F, x.op == I_JNFLT ? 0x86 : 0x82 });
+			fix.push_back(make_pair((int)out.size(), x.a));
+			put32(0);
+			break;
+		case I_JNFGT:
+		case I_JNFGE:
+		case I_JNFEQ:
+			mem_op({ 0xF2, 0x0F, 0x10 }, 0, x.b);
+			mem_op({ 0x66, 0x0F, 0x2E }, 0, x.c);
+			if (x.op == I_JNFEQ) {
+				put({ 0x0F, 0x8A });
+				fix.push_back(make_pair((int)out.size(), x.a));
+				put32(0);
 			}
+			put({ 0x0F, x.op == I_JNFGT ? 0x86 : x.op == I_JNFGE ? 0x82 : 0x85 });
+			fix.push_back(make_pair((int)out.size(), x.a));
+			put32(0);
+			break;
+		case I_JMP:
+			put({ 0xE9 });
+			fix.push_back(make_pair((int)out.size(), x.a));
+			put32(0);
+			break;
+		case I_HALT:
+			epilogue();
+			break;
+		///sub r13, 1λ˵Ѿ꣬VMһкź󷵻
+		case I_LOOP: {
+			put({ 0x49, 0x83, 0xED, 0x01 });
+			int ok = jump8(0x73);
+			call(&NativeCode::loop_limit, p.lines[i]);
+			epilogue();
+			patch8(ok);
+			put({ 0xE9 });
+			fix.push_back(make_pair((int)out.size(), x.a));
+			put32(0);
+			break;
+		}
 		}
-		curline = inputhead.line_num;
 	}
-
-	return op;
+	for (auto& f : fix) {
+		int d = start[f.second] - (f.first + 4);
+		memcpy(&out[f.first], &d, sizeof(d));
+	}
+	size_t page = sysconf(_SC_PAGESIZE);
+	size = (out.size() + page - 1) / page * page;
+	void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (m == MAP_FAILED)
+		return false;
+	memcpy(m, out.data(), out.size());
+	///д֮ȥдȨټִȨޣͬʱдִ
+	if (mprotect(m, size, PROT_READ | PROT_EXEC) != 0) {
+		munmap(m, size);
+		return false;
+	}
+	mem = m;
+	entry = (void (*)(reg*, VM*))m;
+	vector<unsigned char>().swap(out);
+	return true;
+#else
+	return false;
+#endif
 }
 /**
- * չʾ﷨Ľ.
+ * ִcompileɵĻ룬rѾinitʼļĴ飬0vm.div_zero.
+ * ֻ߳̿ԸԼrvmͬʱ.
  *
+ * \param r
+ * \param vm
  */
-void LRparser::show() {
-	e.report();
-	output.push_back("program");
-	string s = "";
-	cout << "program ";
-	for (int i = op.size() - 1; i >= 0; i--) {
-		//cout<<op[i]<<endl;
-		output.pop_back();
-		int num = op[i].num;
-		for (int j = 1; j < g.productions[num].size(); j++)
-			output.push_back(g.productions[num][j]);
+void NativeCode::run(reg* r, VM& vm) const {
+	entry(r, &vm);
+}
+
+/**
+ * õĳLRparser::prepareõ.
+ * ķԴֻһΣ֮òͬĳִֵУ
+ * ֽͱиֻÿִԼļĴVM߳̿ͬʱrun.
+ */
+class PreparedProgram {
+	friend class LRparser;
+private:
+	shared_ptr<const bytecode> prog;
+	shared_ptr<const NativeCode> native;	///ΪʱVMִ
+	ErrorHandler e;	///ͱʱֵĴ
+public:
+	bool ok() const;
+	bool report() const;
+	map<string, typed_value> run(const map<string, typed_value>& init = map<string, typed_value>(), vector<error>* errors = nullptr) const;
+};
+/**
+ * ִܷУ﷨ʹδıʶʱfalse.
+ *
+ * \return
+ */
+bool PreparedProgram::ok() const {
+	return prog && e.empty();
+}
+
+bool PreparedProgram::report() const {
+	ErrorHandler copy = e;
+	return copy.report();
+}
+/**
+ * ִһγ򣬷ıֵ.
+ * initеֵʱĳֵrealֵintʱȡûֱԣ
+ * ͷ.
+ *
+ * \param init
+ * \param errors Ϊʱ¼ʱĴ󣺳0ÿһΣѭ
+ * \return
+ */
+map<string, typed_value> PreparedProgram::run(const map<string, typed_value>& init, vector<error>* errors) const {
+	map<string, typed_value> res;
+	if (!prog)
+		return res;
+	vector<reg> r = prog->init;
+	for (int i = 0; i < prog->ndecl; i++) {
+		auto it = init.find(prog->names[i]);
+		if (it == init.end())
+			continue;
+		if (prog->types[i] == INT)
+			r[i].i = it->second.type == INT ? it->second.v.i : real_to_int(it->second.v.f);
+		else
+			r[i].f = it->second.real();
+	}
+	VM vm;
+	if (native)
+		native->run(r.data(), vm);
+	else
+		vm.run(*prog, r.data());
+	if (errors != nullptr) {
+		for (auto ln : vm.div_zero)
+			errors->push_back(error(DIVIDE_BY_ZERO, ln));
+		if (vm.overrun != -1)
+			errors->push_back(error(LOOP_LIMIT, vm.overrun));
+	}
+	for (int i = 0; i < prog->ndecl; i++)
+		res[prog->names[i]] = prog->types[i] == INT ? typed_value(r[i].i) : typed_value(r[i].f);
+	return res;
+}
+
+///мʾֵ
+enum { V_VAR, V_CONST, V_TEMP };
+/**
+ * ַ룬bytecodeͬdstxyIRProgramеֵţõ-1.
+ */
+struct tac {
+	int op;
+	int dst, x, y;
+	int line_num;
+
+	tac() { op = I_HALT; dst = x = y = -1; line_num = -1; }
+	tac(int o, int d, int a, int b, int ln) { op = o; dst = d; x = a; y = b; line_num = ln; }
+};
+/**
+ * 飬codeûתβתbr.
+ * brI_JMPʱtakenI_JNxxʱȽbr.xbr.ytakenfallI_HALTʱ.
+ */
+struct basic_block {
+	vector<tac> code;
+	tac br;
+	int taken = -1, fall = -1;
+};
+/**
+ * op㣬VMͬ.
+ * Ϊ0ʱ㣬ʱ.
+ *
+ * \param op
+ * \param x
+ * \param y
+ * \param r
+ * \return ܷڱʱ
+ */
+inline bool eval_tac(int op, reg x, reg y, reg& r) {
+	typedef unsigned long long ull;
+	switch (op) {
+	case I_MOVE:
+		r = x;
+		return true;
+	case I_IADD:
+		r.i = (long long)((ull)x.i + (ull)y.i);
+		return true;
+	case I_ISUB:
+		r.i = (long long)((ull)x.i - (ull)y.i);
+		return true;
+	case I_IMUL:
+		r.i = (long long)((ull)x.i * (ull)y.i);
+		return true;
+	case I_IDIV:
+		if (y.i == 0)
+			return false;
+		r.i = y.i == -1 ? (long long)(0ULL - (ull)x.i) : x.i / y.i;
+		return true;
+	case I_FADD:
+		r.f = x.f + y.f;
+		return true;
+	case I_FSUB:
+		r.f = x.f - y.f;
+		return true;
+	case I_FMUL:
+		r.f = x.f * y.f;
+		return true;
+	case I_FDIV:
+		if (y.f == 0)
+			return false;
+		r.f = x.f / y.f;
+		return true;
+	case I_ITOF:
+		r.f = (double)x.i;
+		return true;
+	case I_FTOI:
+		r.i = real_to_int(x.f);
+		return true;
+	}
+	return false;
+}
+/**
+ * I_JNxxȽϵǷʱת.
+ *
+ * \param op
+ * \param x
+ * \param y
+ * \return
+ */
+inline bool eval_cond(int op, reg x, reg y) {
+	switch (op) {
+	case I_JNILT: return x.i < y.i;
+	case I_JNIGT: return x.i > y.i;
+	case I_JNILE: return x.i <= y.i;
+	case I_JNIGE: return x.i >= y.i;
+	case I_JNIEQ: return x.i == y.i;
+	case I_JNFLT: return x.f < y.f;
+	case I_JNFGT: return x.f > y.f;
+	case I_JNFLE: return x.f <= y.f;
+	case I_JNFGE: return x.f >= y.f;
+	case I_JNFEQ: return x.f == y.f;
+	}
+	return false;
+}
+
+/**
+ * ַʽмʾLRparser::build_ir﷨ɣ鰴if/elseĽṹ.
+ * ֵŵǰnvarsǱbytecodeеļĴͬǳʱֵ
+ * ʱֵֵֻһΣֻڶĻʹ.
+ * optimizeдӱʽɾ洢ɾ
+ * assembleʱֵĴbytecode.
+ */
+class IRProgram {
+public:
+	vector<basic_block> blocks;	///blocks[0]
+	vector<string> names;	///ǰndeclı
+	vector<int> types;	///
+	vector<reg> init;	///ĳֵ
+	int ndecl = 0;
+	int nvars = 0;
+	vector<int> vkind;	///ÿֵ
+	vector<int> vtype;	///ÿֵ
+	vector<reg> vconst;	///ֵ
+
+	void start();
+	int new_block();
+	int temp(int type);
+	int konst(int type, reg v);
+	void optimize();
+	bytecode assemble() const;
+	void show(ostream& os) const;
+private:
+	map<pair<int, long long>, int> kids;	///ͺͶƱʾȥ
+	vector<vector<int>> succs() const;
+	vector<int> layout() const;
+	bool may_trap(const tac& t) const;
+	bool is_const(int v) const { return v >= 0 && vkind[v] == V_CONST; }
+	bool is_var(int v) const { return v >= 0 && v < nvars; }
+	bool propagate();
+	bool walk(int b, vector<int>& st, vector<int>& tval, vector<vector<int>>& tw, bool rewrite);
+	bool cse();
+	bool dse();
+	bool thread_jumps();
+	bool merge_blocks();
+	void coalesce();
+	string value_name(int v) const;
+};
+/**
+ * ȷ֮ʼɴ룬ֻһյڿ.
+ *
+ */
+void IRProgram::start() {
+	nvars = names.size();
+	vkind.assign(nvars, V_VAR);
+	vtype = types;
+	vconst.assign(nvars, reg());
+	blocks.assign(1, basic_block());
+	kids.clear();
+}
+
+int IRProgram::new_block() {
+	blocks.push_back(basic_block());
+	return blocks.size() - 1;
+}
+
+int IRProgram::temp(int type) {
+	vkind.push_back(V_TEMP);
+	vtype.push_back(type);
+	vconst.push_back(reg());
+	return vkind.size() - 1;
+}
+/**
+ * ȡֵţͺͶƱʾͬĳֻһţ-00ǲͬĳ.
+ *
+ * \param type
+ * \param v
+ * \return
+ */
+int IRProgram::konst(int type, reg v) {
+	auto key = make_pair(type, v.i);
+	auto it = kids.find(key);
+	if (it != kids.end())
+		return it->second;
+	vkind.push_back(V_CONST);
+	vtype.push_back(type);
+	vconst.push_back(v);
+	return kids[key] = vkind.size() - 1;
+}
+
+vector<vector<int>> IRProgram::succs() const {
+	vector<vector<int>> s(blocks.size());
+	for (int b = 0; b < blocks.size(); b++) {
+		if (blocks[b].br.op == I_HALT)
+			continue;
+		s[b].push_back(blocks[b].taken);
+		if (blocks[b].br.op != I_JMP && blocks[b].br.op != I_LOOP)
+			s[b].push_back(blocks[b].fall);
+	}
+	return s;
+}
+/**
+ * ܵĻ飬Уŵ˳Դ˳.
+ *
+ * \return
+ */
+vector<int> IRProgram::layout() const {
+	auto s = succs();
+	vector<bool> seen(blocks.size(), false);
+	vector<int> stack(1, 0), order;
+	seen[0] = true;
+	while (!stack.empty()) {
+		int b = stack.back();
+		stack.pop_back();
+		for (auto c : s[b]) {
+			if (!seen[c]) {
+				seen[c] = true;
+				stack.push_back(c);
+			}
+		}
+	}
+	for (int b = 0; b < blocks.size(); b++) {
+		if (seen[b])
+			order.push_back(b);
+	}
+	return order;
+}
+/**
+ * Ƿ0ĳʱɾߺϲ.
+ *
+ * \param t
+ * \return
+ */
+bool IRProgram::may_trap(const tac& t) const {
+	if (t.op != I_IDIV && t.op != I_FDIV)
+		return false;
+	if (!is_const(t.y))
+		return true;
+	return t.op == I_IDIV ? vconst[t.y].i == 0 : vconst[t.y].f == 0;
+}
+/**
+ * ȫֵĳ͸д.
+ * ÿ״̬һֵţȵĳ-1δ֪ڿͼϵ㣬
+ * ʱ״̬ͬͱδ֪.ڲʱֵҲ״̬¸ֵʱָ״̬.
+ * ǳֱǳתĳת.
+ *
+ * \return Ƿ޸˴
+ */
+bool IRProgram::propagate() {
+	int nb = blocks.size();
+	auto s = succs();
+	vector<vector<int>> preds(nb), out(nb);
+	for (int b = 0; b < nb; b++) {
+		for (auto c : s[b])
+			preds[c].push_back(b);
+	}
+	vector<int> tval(vkind.size(), -1), st;
+	vector<vector<int>> tw(nvars);
+	///ûǰϣڵıδ֪
+	auto meet = [&](int b) -> bool {
+		if (b == 0) {
+			st.assign(nvars, -1);
+			return true;
+		}
+		bool first = true;
+		for (auto p : preds[b]) {
+			if (out[p].empty())
+				continue;
+			if (first)
+				st = out[p];
+			else {
+				for (int v = 0; v < nvars; v++) {
+					if (st[v] != out[p][v])
+						st[v] = -1;
+				}
+			}
+			first = false;
+		}
+		return !first;
+	};
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int b = 0; b < nb; b++) {
+			if (!meet(b))
+				continue;
+			walk(b, st, tval, tw, false);
+			if (st != out[b]) {
+				out[b] = st;
+				changed = true;
+			}
+		}
+	}
+	bool res = false;
+	for (int b = 0; b < nb; b++) {
+		if (meet(b))
+			res |= walk(b, st, tval, tw, true);
+	}
+	return res;
+}
+/**
+ * ڻbϰ˳ִдstǽʱ״̬ʱǳڵ״̬.
+ * rewriteΪtrueʱ滻۵Ľдش.
+ *
+ * \param b
+ * \param st
+ * \param tval ʱֵ״̬
+ * \param tw ÿЩʱֵ״̬
+ * \param rewrite
+ * \return Ƿ޸˴
+ */
+bool IRProgram::walk(int b, vector<int>& st, vector<int>& tval, vector<vector<int>>& tw, bool rewrite) {
+	basic_block& bb = blocks[b];
+	vector<int> touched;
+	bool changed = false;
+	auto sub = [&](int v) -> int {
+		if (is_var(v) && st[v] >= 0)
+			return st[v];
+		if (v >= 0 && vkind[v] == V_TEMP && tval[v] >= 0)
+			return tval[v];
+		return v;
+	};
+	auto kill = [&](int d) {
+		for (int v = 0; v < nvars; v++) {
+			if (st[v] == d)
+				st[v] = -1;
+		}
+		for (auto t : tw[d]) {
+			if (tval[t] == d)
+				tval[t] = -1;
+		}
+		tw[d].clear();
+	};
+	vector<tac> nc;
+	for (auto t : bb.code) {
+		tac o = t;
+		t.x = sub(t.x);
+		t.y = sub(t.y);
+		reg r;
+		if (t.op != I_MOVE && is_const(t.x) && (t.y == -1 || is_const(t.y)) && eval_tac(t.op, vconst[t.x], t.y == -1 ? reg() : vconst[t.y], r))
+			t = tac(I_MOVE, t.dst, konst(vtype[t.dst], r), -1, t.line_num);
+		int d = t.dst;
+		if (t.op == I_MOVE && t.x == d) {
+			changed = true;
+			continue;
+		}
+		if (is_var(d)) {
+			kill(d);
+			st[d] = -1;
+			if (t.op == I_MOVE && vkind[t.x] == V_TEMP) {
+				tval[t.x] = d;
+				tw[d].push_back(t.x);
+				touched.push_back(t.x);
+			}
+			else if (t.op == I_MOVE)
+				st[d] = t.x;
+		}
+		else if (t.op == I_MOVE) {
+			tval[d] = t.x;
+			touched.push_back(d);
+			if (is_var(t.x))
+				tw[t.x].push_back(d);
+		}
+		if (t.op != o.op || t.x != o.x || t.y != o.y)
+			changed = true;
+		nc.push_back(t);
+	}
+	tac br = bb.br;
+	br.x = sub(br.x);
+	br.y = sub(br.y);
+	int taken = bb.taken, fall = bb.fall;
+	if (br.op != I_JMP && br.op != I_HALT && is_const(br.x) && is_const(br.y)) {
+		if (eval_cond(br.op, vconst[br.x], vconst[br.y]))
+			taken = fall;
+		br = tac(I_JMP, -1, -1, -1, br.line_num);
+		fall = -1;
+	}
+	if (br.op != bb.br.op || br.x != bb.br.x || br.y != bb.br.y)
+		changed = true;
+	for (auto t : touched)
+		tval[t] = -1;
+	for (auto& w : tw)
+		w.clear();
+	if (rewrite) {
+		bb.code.swap(nc);
+		bb.br = br;
+		bb.taken = taken;
+		bb.fall = fall;
+	}
+	return changed;
+}
+/**
+ * ڵĹӱʽɾֵż¼Ѿ(op, x, y)
+ * ٴγʱĳɴӱֵƣ֮ĸд洢ɾȥĴ.
+ * ܳ0ĳϲ.
+ *
+ * \return Ƿ޸˴
+ */
+bool IRProgram::cse() {
+	bool changed = false;
+	for (auto& bb : blocks) {
+		map<array<int, 3>, int> avail;
+		map<int, vector<array<int, 3>>> dep;	///¸ֵʱҪϵıʽ
+		for (auto& t : bb.code) {
+			int d = t.dst;
+			bool pure = t.op != I_MOVE && !may_trap(t);
+			array<int, 3> key = { { t.op, t.x, t.y } };
+			if ((t.op == I_IADD || t.op == I_IMUL || t.op == I_FADD || t.op == I_FMUL) && key[1] > key[2])
+				swap(key[1], key[2]);
+			auto it = pure ? avail.find(key) : avail.end();
+			bool hit = it != avail.end();
+			if (hit) {
+				t = tac(I_MOVE, d, it->second, -1, t.line_num);
+				changed = true;
+			}
+			if (is_var(d)) {
+				for (auto& k : dep[d])
+					avail.erase(k);
+				dep[d].clear();
+			}
+			if (pure && !hit && d != t.x && d != t.y) {
+				avail[key] = d;
+				for (int v : { t.x, t.y, d }) {
+					if (is_var(v))
+						dep[v].push_back(key);
+				}
+			}
+		}
+	}
+	return changed;
+}
+/**
+ * 洢ɾڿͼϷÿڻԾı
+ * ʱֻıǻԾģɾٱõĸֵ.
+ *
+ * \return Ƿ޸˴
+ */
+bool IRProgram::dse() {
+	int nb = blocks.size();
+	auto s = succs();
+	vector<vector<char>> in(nb, vector<char>(nvars, 0));
+	///liveеֵʱֵֻڿڻԾÿʱùλ
+	vector<char> live(vkind.size(), 0);
+	vector<int> touched;
+	auto mark = [&](int v) {
+		if (v >= nvars && vkind[v] == V_TEMP && !live[v])
+			touched.push_back(v);
+		if (v >= 0)
+			live[v] = 1;
+	};
+	auto live_out = [&](int b) {
+		for (auto t : touched)
+			live[t] = 0;
+		touched.clear();
+		for (int v = 0; v < nvars; v++)
+			live[v] = blocks[b].br.op == I_HALT && v < ndecl;
+		for (auto c : s[b]) {
+			for (int v = 0; v < nvars; v++)
+				live[v] |= in[c][v];
+		}
+		mark(blocks[b].br.x);
+		mark(blocks[b].br.y);
+	};
+	auto step = [&](const tac& t) -> bool {
+		if (!live[t.dst] && !may_trap(t))
+			return false;
+		live[t.dst] = 0;
+		mark(t.x);
+		mark(t.y);
+		return true;
+	};
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (int b = nb - 1; b >= 0; b--) {
+			live_out(b);
+			for (int i = blocks[b].code.size() - 1; i >= 0; i--)
+				step(blocks[b].code[i]);
+			if (!equal(in[b].begin(), in[b].end(), live.begin())) {
+				copy(live.begin(), live.begin() + nvars, in[b].begin());
+				changed = true;
+			}
+		}
+	}
+	bool res = false;
+	for (int b = 0; b < nb; b++) {
+		live_out(b);
+		vector<tac>& code = blocks[b].code;
+		vector<tac> kept;
+		for (int i = code.size() - 1; i >= 0; i--) {
+			if (step(code[i]))
+				kept.push_back(code[i]);
+		}
+		if (kept.size() != code.size()) {
+			res = true;
+			code.assign(kept.rbegin(), kept.rend());
+		}
+	}
+	return res;
+}
+/**
+ * תֻ̻߳һתĿտʱֱյĿꣻ
+ * תĿͬʱĳתȽûиãֱȥ.
+ *
+ * \return Ƿ޸˴
+ */
+bool IRProgram::thread_jumps() {
+	///յѭת߲ͷblocks.size()
+	auto target = [&](int b) {
+		for (int k = 0; k < blocks.size() && blocks[b].code.empty() && blocks[b].br.op == I_JMP; k++)
+			b = blocks[b].taken;
+		return b;
+	};
+	bool changed = false;
+	for (auto& bb : blocks) {
+		if (bb.br.op == I_HALT)
+			continue;
+		bool cond = bb.br.op != I_JMP && bb.br.op != I_LOOP;
+		int t = target(bb.taken);
+		int f = cond ? target(bb.fall) : -1;
+		if (t != bb.taken || f != bb.fall) {
+			bb.taken = t;
+			bb.fall = f;
+			changed = true;
+		}
+		if (cond && bb.taken == bb.fall) {
+			bb.br = tac(I_JMP, -1, -1, -1, bb.br.line_num);
+			bb.fall = -1;
+			changed = true;
+		}
+	}
+	return changed;
+}
+/**
+ * תĿֻһǰʱĿӵ棬ϲһ飬
+ * ifǰĴҲڵĹӱʽɾ.ϲĿպٿɴ.
+ *
+ * \return Ƿ޸˴
+ */
+bool IRProgram::merge_blocks() {
+	auto s = succs();
+	vector<int> npred(blocks.size(), 0);
+	for (auto b : layout()) {
+		for (auto c : s[b])
+			npred[c]++;
+	}
+	bool changed = false;
+	for (auto b : layout()) {
+		basic_block& bb = blocks[b];
+		while (bb.br.op == I_JMP && bb.taken != b && bb.taken != 0 && npred[bb.taken] == 1) {
+			basic_block& c = blocks[bb.taken];
+			bb.code.insert(bb.code.end(), c.code.begin(), c.code.end());
+			bb.br = c.br;
+			bb.fall = c.fall;
+			bb.taken = c.taken;
+			c.code.clear();
+			c.br = tac();
+			c.taken = c.fall = -1;
+			changed = true;
+		}
+	}
+	return changed;
+}
+/**
+ * ʱֵֻŵһõʱֱӰѽдƵĿ.
+ *
+ */
+void IRProgram::coalesce() {
+	vector<int> uses(vkind.size(), 0);
+	for (auto& bb : blocks) {
+		for (auto& t : bb.code) {
+			if (t.x >= 0)
+				uses[t.x]++;
+			if (t.y >= 0)
+				uses[t.y]++;
+		}
+		if (bb.br.x >= 0)
+			uses[bb.br.x]++;
+		if (bb.br.y >= 0)
+			uses[bb.br.y]++;
+	}
+	for (auto& bb : blocks) {
+		vector<tac> nc;
+		for (auto& t : bb.code) {
+			if (t.op == I_MOVE && vkind[t.x] == V_TEMP && uses[t.x] == 1 && !nc.empty() && nc.back().dst == t.x)
+				nc.back().dst = t.dst;
+			else
+				nc.push_back(t);
+		}
+		bb.code.swap(nc);
+	}
+}
+/**
+ * Żֱĳһûκ޸.
+ *
+ */
+void IRProgram::optimize() {
+	for (int round = 0; round < 8; round++) {
+		bool changed = propagate();
+		changed |= cse();
+		changed |= dse();
+		changed |= thread_jumps();
+		changed |= merge_blocks();
+		if (!changed)
+			break;
+	}
+	coalesce();
+}
+/**
+ * bytecode.
+ * ļĴŲ䣬֮õĳʱֵʱֵһʹúͿԸã
+ * 鰴Уһתʡ.
+ *
+ * \return
+ */
+bytecode IRProgram::assemble() const {
+	bytecode p;
+	p.names = names;
+	p.types = types;
+	p.ndecl = ndecl;
+	p.init = init;
+	vector<int> order = layout();
+	vector<int> where(vkind.size(), -1);
+	for (int v = 0; v < nvars; v++)
+		where[v] = v;
+	auto place_const = [&](int v) {
+		if (is_const(v) && where[v] == -1) {
+			where[v] = p.init.size();
+			p.init.push_back(vconst[v]);
+		}
+	};
+	for (auto b : order) {
+		for (auto& t : blocks[b].code) {
+			place_const(t.x);
+			place_const(t.y);
+		}
+		place_const(blocks[b].br.x);
+		place_const(blocks[b].br.y);
+	}
+	int nregs = p.init.size();
+	vector<int> free_regs, last(vkind.size(), -1), start(blocks.size(), -1);
+	vector<pair<int, int>> fix;	///ҪĿתָĿ
+	auto reg_of = [&](int v) { return v == -1 ? 0 : where[v]; };
+	for (int k = 0; k < order.size(); k++) {
+		const basic_block& bb = blocks[order[k]];
+		start[order[k]] = p.code.size();
+		for (int i = 0; i < bb.code.size(); i++) {
+			for (int v : { bb.code[i].x, bb.code[i].y }) {
+				if (v >= 0 && vkind[v] == V_TEMP)
+					last[v] = i;
+			}
+		}
+		for (int v : { bb.br.x, bb.br.y }) {
+			if (v >= 0 && vkind[v] == V_TEMP)
+				last[v] = bb.code.size();
+		}
+		for (int i = 0; i < bb.code.size(); i++) {
+			const tac& t = bb.code[i];
+			int a = reg_of(t.x), b = reg_of(t.y);
+			for (int v : { t.x, t.y }) {
+				if (v >= 0 && vkind[v] == V_TEMP && last[v] == i && where[v] != -1) {
+					free_regs.push_back(where[v]);
+					where[v] = -1;
+				}
+			}
+			int d = t.dst;
+			if (vkind[d] == V_TEMP) {
+				if (free_regs.empty())
+					free_regs.push_back(nregs++);
+				where[d] = free_regs.back();
+				free_regs.pop_back();
+			}
+			p.code.push_back(insn(t.op, where[d], a, b));
+			p.lines.push_back(t.line_num);
+			if (vkind[d] == V_TEMP && last[d] <= i) {
+				free_regs.push_back(where[d]);
+				where[d] = -1;
+			}
+		}
+		int next = k + 1 < order.size() ? order[k + 1] : -1;
+		const tac& br = bb.br;
+		if (br.op == I_HALT) {
+			p.code.push_back(insn(I_HALT, 0, 0, 0));
+			p.lines.push_back(br.line_num);
+			continue;
+		}
+		///ѭرҪʹĿһҲʡ
+		if (br.op == I_LOOP) {
+			fix.push_back(make_pair(p.code.size(), bb.taken));
+			p.code.push_back(insn(I_LOOP, -1, 0, 0));
+			p.lines.push_back(br.line_num);
+			continue;
+		}
+		if (br.op != I_JMP) {
+			fix.push_back(make_pair(p.code.size(), bb.taken));
+			p.code.push_back(insn(br.op, -1, reg_of(br.x), reg_of(br.y)));
+			p.lines.push_back(br.line_num);
+			for (int v : { br.x, br.y }) {
+				if (v >= 0 && vkind[v] == V_TEMP && where[v] != -1) {
+					free_regs.push_back(where[v]);
+					where[v] = -1;
+				}
+			}
+		}
+		int to = br.op == I_JMP ? bb.taken : bb.fall;
+		if (to != next) {
+			fix.push_back(make_pair(p.code.size(), to));
+			p.code.push_back(insn(I_JMP, -1, 0, 0));
+			p.lines.push_back(br.line_num);
+		}
+	}
+	for (auto& f : fix)
+		p.code[f.first].a = start[f.second];
+	p.init.resize(nregs);
+	return p;
+}
+
+string IRProgram::value_name(int v) const {
+	if (v < nvars)
+		return names[v];
+	if (vkind[v] == V_TEMP)
+		return "t" + to_string(v);
+	ostringstream os;
+	if (vtype[v] == INT)
+		os << vconst[v].i;
+	else
+		os << vconst[v].f << "r";
+	return os.str();
+}
+/**
+ * м룬rʾreal.
+ *
+ * \param os
+ */
+void IRProgram::show(ostream& os) const {
+	static const char* mnemonic[] = { "move", "iadd", "isub", "imul", "idiv", "fadd", "fsub", "fmul", "fdiv", "itof", "ftoi",
+		"jnilt", "jnigt", "jnile", "jnige", "jnieq", "jnflt", "jnfgt", "jnfle", "jnfge", "jnfeq", "jmp", "halt", "loop" };
+	for (auto b : layout()) {
+		const basic_block& bb = blocks[b];
+		os << "B" << b << ":" << endl;
+		for (auto& t : bb.code) {
+			os << "\t" << value_name(t.dst) << " = " << mnemonic[t.op] << " " << value_name(t.x);
+			if (t.y >= 0)
+				os << ", " << value_name(t.y);
+			os << endl;
+		}
+		os << "\t" << mnemonic[bb.br.op];
+		if (bb.br.op == I_JMP || bb.br.op == I_LOOP)
+			os << " B" << bb.taken;
+		else if (bb.br.op != I_HALT)
+			os << " " << value_name(bb.br.x) << ", " << value_name(bb.br.y) << " B" << bb.taken << " else B" << bb.fall;
+		os << endl;
+	}
+}
+
+/**
+ * ʷLexicalAnalysis.hеLexAnalyzerд
+ * ֱɨԴõкŵtokenҪȰСոз֣
+ * жtypevalueԱʶתΪnameID token
+ * ͨtidtokenӳķսı.
+ */
+class LexAnalyzer {
+public:
+	string input;
+	map<string, int> tid;
+	int unknown;
+	int line;
+	vector<token> res;
+	RingBuffer<vector<token>>* sink = nullptr;	///Ϊʱÿܹbatchtokenͽˮ
+	int batch = 256;
+	LexAnalyzer(Generator& g);
+	void execute(string input);
+	void add(token t);
+	int get_num(int pos, string word);
+	int get_operator(int pos, string word);
+	int get_alpha(int pos, string word);
+};
+/**
+ * ķսʼid.
+ *
+ * \param g
+ */
+LexAnalyzer::LexAnalyzer(Generator& g) {
+	for (auto t : g.term) {
+		if (t != "E" && t != "$")
+			tid[t] = g.sid[t];
+	}
+	unknown = g.sid.size();
+	line = 1;
+}
+/**
+ * ¼һtokenstrս.
+ *
+ * \param t
+ */
+void LexAnalyzer::add(token t) {
+	auto it = tid.find(t.str);
+	t.sym = (it == tid.end()) ? unknown : it->second;
+	res.push_back(t);
+	if (sink != nullptr && res.size() >= batch)
+		sink->push(res);
+}
+/**
+ * ֲvalueСREALNUMINTNUM
+ * tokenһַλ.
+ *
+ * \param pos
+ * \param word
+ * \return
+ */
+int LexAnalyzer::get_num(int pos, string word) {
+	int j = pos;
+	int dot_pos = -1;
+	while (j + 1 < input.length()) {
+		j++;
+		if (isDigit(input[j]))
+			;
+		else if (input[j] == '.' && dot_pos == -1)
+			dot_pos = word.length();
+		else
+			break;
+		word += input[j];
+	}
+	if (dot_pos == -1)
+		dot_pos = word.length();
+	double temp = 0;
+	double mult = 1;
+	for (int i = dot_pos - 1; i >= 0; i--) {
+		temp += (word[i] - '0')*mult;
+		mult *= 10;
+	}
+	if (dot_pos == word.length())
+		add(token("INTNUM", temp, INT, line));
+	else {
+		double frac = 0;
+		mult = 0.1;
+		for (int i = dot_pos + 1; i < word.length(); i++) {
+			frac += (word[i] - '0')*mult;
+			mult /= 10;
+		}
+		add(token("REALNUM", temp + frac, REAL, line));
+	}
+	return pos + word.length() - 1;
+}
+/**
+ * ͽַսʱȡģ
+ * עͣtokenһַλ.
+ *
+ * \param pos
+ * \param word
+ * \return
+ */
+int LexAnalyzer::get_operator(int pos, string word) {
+	int i = pos;
+	if (i + 1 < input.length()) {
+		if (input[i] == '/' && input[i + 1] == '/') {
+			while (i + 1 < input.length() && input[i + 1] != '\n')
+				i++;
+			return i;
+		}
+		if (input[i] == '/' && input[i + 1] == '*') {
+			i += 2;
+			while (i + 1 < input.length() && !(input[i] == '*' && input[i + 1] == '/')) {
+				if (input[i] == '\n')
+					line++;
+				i++;
+			}
+			return i + 1;
+		}
+		if (tid.count(input.substr(i, 2)))
+			word += input[i + 1];
+	}
+	add(token(word, -1, -1, line));
+	return pos + word.length() - 1;
+}
+/**
+ * ܹؼֻ߱ʶʶתΪnameID token
+ * tokenһַλ.
+ *
+ * \param pos
+ * \param word
+ * \return
+ */
+int LexAnalyzer::get_alpha(int pos, string word) {
+	int j = pos;
+	while (j + 1 < input.length() && (isDigit(input[j + 1]) || isAlpha(input[j + 1]))) {
+		j++;
+		word += input[j];
+	}
+	if (tid.count(word))
+		add(token(word, -1, -1, line));
+	else
+		add(token("ID", word, ID, line));
+	return pos + word.length() - 1;
+}
+/**
+ * ɨ룬ַѡtokenķʽ
+ * sinkʱͳʣµtokenһʾ.
+ *
+ * \param raw_input
+ */
+void LexAnalyzer::execute(string raw_input) {
+	input = raw_input;
+	res.clear();
+	res.reserve(sink == nullptr ? input.length() / 2 + 1 : batch);
+	for (int i = 0; i < input.length(); i++) {
+		char c = input[i];
+		if (c == '\n')
+			line++;
+		else if (c == ' ' || c == '\t' || c == '\r')
+			;
+		else if (isDigit(c))
+			i = get_num(i, string(1, c));
+		else if (isAlpha(c))
+			i = get_alpha(i, string(1, c));
+		else
+			i = get_operator(i, string(1, c));
+	}
+	if (sink != nullptr) {
+		if (!res.empty())
+			sink->push(res);
+		sink->push(res);
+	}
+}
+
+class  LRparser {
+private:
+	vector<token> tokens;
+	deque<token> input;
+	deque<token> work;	///stateֵջʽֵʹvaluetype
+	deque<int> state;
+	vector<entry> op;
+	deque<string> output;
+	vector<int> rtype;	///ʽӦ嶯
+	vector<string> fold_ops;	///FOLDʽڵprimeϵ
+	ErrorHandler e;
+	map<string, typed_value> id_value;	///ִнֻtranslate֮Ч
+	Generator g;
+	bool record_op = true;	///ˮģʽopshow
+	vector<int> rlen;	///ʽҲȥEĳ
+	vector<int> lhs;	///ʽ󲿵ķű
+	vector<int> repair_syms;	///Բ滻ս";"ǰ
+	vector<int> sim_state;	///try_repairѹ״̬
+	int repair_window = 3;	///޸ʱ󿴵token
+	int repair_budget = 64;	///һ޸ʱִеĶ
+	bool repaired = false;	///﷨޸滻tokenûʵֵֺٷ
+	vector<string> ids;	///˳еı
+	vector<ast_node> tree;	///Լʱ﷨
+	int root = -1;	///compoundstmt
+	vector<map<string, int>> scopes;	///resolveʱ⵽ڵֵλ
+	int cur;	///gen_stmtдĻ
+	vector<int> fdiv_zero;	///ǳ0ûлrealڵ
+	void action(int pid, int n, token& res);
+	int new_node(int kind, int ln);
+	void resolve(int n, IRProgram& p);
+	int bind(int n, IRProgram& p, int etype);
+	void typecheck(int n, IRProgram& p);
+	int type_of(int n);
+	void promote(int n);
+	int fold(int n, IRProgram& p);
+	int simplify(int n);
+	bool is_const(int n);
+	bool is_value(int n, long long v);
+	bool pure(int n);
+	int make_const(int n, long long iv, double fv);
+	IRProgram build_ir();
+	int gen_expr(int n, IRProgram& ir);
+	int gen_as(int n, int type, IRProgram& ir);
+	void gen_store(int d, int v, int type, int ln, IRProgram& ir);
+	void gen_cond(int n, IRProgram& ir, int taken, int fall);
+	void gen_stmt(int n, IRProgram& ir);
+	void emit(IRProgram& ir, int op, int d, int x, int y, int ln);
+	PreparedProgram package(bool hot);
+public:
+	bool use_jit = true;	///Ƿɱ룬֧ʱԶ˻VM
+	long long max_iterations = 100000000;	///һִwhileѭϼĴ
+	void init_table(string raw_input);
+	vector<entry> execute(string input);
+	void parse(RingBuffer<vector<token>>* src);
+	bool refill(RingBuffer<vector<token>>*& src);
+	int try_repair(const vector<int>& seq);
+	bool recover(RingBuffer<vector<token>>*& src, int curline);
+	void show();
+	bytecode compile();
+	void show_ir();
+	PreparedProgram prepare(string input);
+	void translate();
+	void print_values();
+	void execute_pipelined(string input, int batch = 256, int depth = 64);
+};
+
+void LRparser::init_table(string raw_input) {
+	g = Generator(raw_input);
+	g.generate_dic();
+	g.generate_first();
+	g.generate_follow();
+	g.generate_canonical_collection();
+
+	rtype.assign(g.productions.size(), EMPTY);
+	rtype[4] = DECLARE; rtype[5] = DECLARE; rtype[12] = IF; rtype[13] = ASSIGN; rtype[14] = BOOL; rtype[20] = ARITH;
+	rtype[21] = ARITHPRIME; rtype[22] = ARITHPRIME; rtype[24] = ARITH; rtype[25] = ARITHPRIME; rtype[26] = ARITHPRIME;
+	rtype[28] = IDVALUE; rtype[29] = INSTANT; rtype[30] = INSTANT; rtype[31] = ARITH;
+	rtype[15] = BOOLOP; rtype[16] = BOOLOP; rtype[17] = BOOLOP; rtype[18] = BOOLOP; rtype[19] = BOOLOP;
+	rtype[23] = FOLD; rtype[27] = FOLD;
+	rtype[32] = INSTANT; rtype[33] = INSTANT;
+	rtype[34] = PASS; rtype[35] = WHILE;
+	rtype[1] = PROGRAM; rtype[2] = STMTS; rtype[6] = PASS; rtype[7] = PASS; rtype[8] = PASS; rtype[9] = BLOCK; rtype[10] = STMTS;
+	fold_ops.assign(g.productions.size(), "");
+	for (int i = 0; i < g.productions.size(); i++) {
+		for (int j = 0; j < g.productions.size(); j++) {
+			if (rtype[i] == ARITHPRIME && rtype[j] == FOLD && g.productions[i][0] == g.productions[j][0])
+				fold_ops[j] += g.productions[i][1];
+		}
+	}
+
+	for (auto& p : g.productions) {
+		int n = 0;
+		for (int i = 1; i < p.size(); i++) {
+			if (p[i] != "E")
+				n++;
+		}
+		rlen.push_back(n);
+		lhs.push_back(g.sid[p[0]]);
+	}
+	repair_syms.push_back(g.sid[";"]);
+	for (auto t : g.term) {
+		if (t != "E" && t != "$" && t != ";")
+			repair_syms.push_back(g.sid[t]);
+	}
+}
+/**
+ * ִʺ
+ * ķ򰴿ոָɴкϢtoken
+ * ֻGeneratorȡķԴLexAnalyzer.
+ *
+ * \param s
+ * \return
+ */
+vector<token> split_word(string s) {
+	vector<string> split_temp;
+	vector<token> split_res;
+	split_res.clear();
+	string line = "";
+	string word = "";
+	for (auto c : s) {
+		if (c == '\n') {
+			if (line != "")
+				split_temp.push_back(line);
+			line = "";
+		}
+		else
+			line += c;
+	}
+	if (line != "")
+		split_temp.push_back(line);
+	for (int i = 0; i < split_temp.size(); i++) {
+		word = "";
+		for (auto c : split_temp[i]) {
+			if (c == ' ') {
+				if (word != "")
+					split_res.push_back(token(word, -1, -1, i + 1));
+				word = "";
+			}
+			else
+				word += c;
+		}
+		if (word != "")
+			split_res.push_back(token(word, -1, -1, i + 1));
+	}
+	return split_res;
+}
+/**
+ * ﷨
+ * նӦ룬LexAnalyzerõսŵtoken
+ * dequeģջBottom-up﷨
+ * ÿιԼʱִ嶯﷨translateִֽ.
+ *
+ * \param input_string
+ * \return
+ */
+vector<entry> LRparser::execute(string input_string) {
+	LexAnalyzer lex(g);
+	lex.execute(input_string);
+	tokens = lex.res;
+	for (int i = tokens.size() - 1; i >= 0; i--)
+		input.push_front(tokens[i]);
+	input.push_back(token("$", -1, -1, -1));
+	input.back().sym = g.sid["$"];
+	parse(nullptr);
+	return op;
+}
+/**
+ * LRѭ
+ * srcΪʱֻinputinputsrcȡһtokenȡʱ$.
+ *
+ * \param src
+ */
+void LRparser::parse(RingBuffer<vector<token>>* src) {
+	vector<token> tbatch;
+	state.push_front(0);
+
+	token workhead; token inputhead; int statehead; entry curop; int curline = 1;
+
+	while (true) {
+		if (input.empty()) {
+			if (!refill(src))
+				break;
+			continue;
+		}
+		statehead = state.front();
+		inputhead = input.front();
+		//cout << "line " << curline << " : " << statehead << ' ' << inputhead.str << ' ';
+		curop = g.slrtable[statehead][inputhead.sym];
+		//cout<<curop.type<<' '<<curop.num<<endl;
+		if (curop.type == ACC)
+			break;
+		if (curop.type == SHIFT) {
+			work.push_front(inputhead);
+			input.pop_front();
+			state.push_front(curop.num);
+		}
+		if (curop.type == REDUCE) {
+			if (record_op)
+				op.push_back(curop);
+			int n = rlen[curop.num];
+			token res(g.productions[curop.num][0], -1, -1, inputhead.line_num);
+			action(curop.num, n, res);
+			for (int i = 0; i < n; i++) {
+				work.pop_front();
+				state.pop_front();
+			}
+			work.push_front(res);
+			entry temp = g.slrtable[state.front()][lhs[curop.num]];
+			//cout << state.front() << ' ' << g.productions[curop.num][0] << ' ' << temp.type << ' ' << temp.num << endl;
+			state.push_front(temp.num);
+			if (temp.type == ACC)
+				break;
+		}
+		if (curop.type == -1 && !recover(src, curline))
+			break;
+		curline = inputhead.line_num;
+	}
+	///ǰʱʣµtokenȡ꣬ôʷ߳һֱĻ
+	while (src != nullptr) {
+		src->pop(tbatch);
+		if (tbatch.empty())
+			src = nullptr;
+	}
+}
+/**
+ * srcȡһtokenӵinput棬ȡʱ$srcÿգ
+ * srcѾΪʱfalse.
+ *
+ * \param src
+ * \return
+ */
+bool LRparser::refill(RingBuffer<vector<token>>*& src) {
+	if (src == nullptr)
+		return false;
+	vector<token> tbatch;
+	src->pop(tbatch);
+	if (tbatch.empty()) {
+		input.push_back(token("$", -1, -1, -1));
+		input.back().sym = g.sid["$"];
+		src = nullptr;
+	}
+	for (auto& t : tbatch)
+		input.push_back(t);
+	return true;
+}
+/**
+ * ڲĶstateջŷseq
+ * ԼʵջԪֻ¼ѹ״̬sim_stateУ
+ * ִrepair_budget֤ÿγĴ.
+ * رƽtokenACCʱseq.size() + 1.
+ *
+ * \param seq
+ * \return
+ */
+int LRparser::try_repair(const vector<int>& seq) {
+	int depth = 0;	///ѾʵջԪظ
+	sim_state.clear();
+	int i = 0;
+	for (int steps = 0; i < seq.size() && steps < repair_budget; steps++) {
+		int top = sim_state.empty() ? state[depth] : sim_state.back();
+		entry a = g.slrtable[top][seq[i]];
+		if (a.type == SHIFT) {
+			sim_state.push_back(a.num);
+			i++;
+		}
+		else if (a.type == REDUCE) {
+			for (int k = 0; k < rlen[a.num]; k++) {
+				if (!sim_state.empty())
+					sim_state.pop_back();
+				else
+					depth++;
+			}
+			top = sim_state.empty() ? state[depth] : sim_state.back();
+			entry go = g.slrtable[top][lhs[a.num]];
+			if (go.type == ACC)
+				return seq.size() + 1;
+			sim_state.push_back(go.num);
+		}
+		else if (a.type == ACC)
+			return seq.size() + 1;
+		else
+			return i;
+	}
+	return i;
+}
+/**
+ * Burke-Fisherʽľֲ޸input.front()ǳtoken
+ * γǰһսɾ滻һս
+ * try_repair޸֮repair_windowtoken߶ԶѡߵԶģͬʱ˳.
+ * ֻԽtoken޸ÿ޸һtokenʱԵģ
+ * $ǰûпõĲʱ󲢷falseʹ˽.
+ * ޸ֻΪ˼Һ﷨޸ĳִУñ޸Ĵ.
+ *
+ * \param src
+ * \param curline
+ * \return
+ */
+bool LRparser::recover(RingBuffer<vector<token>>*& src, int curline) {
+	repaired = true;
+	while (input.size() <= repair_window && refill(src))
+		;
+	token bad = input.front();
+	vector<int> ctx;
+	for (int i = 0; i < input.size() && i <= repair_window; i++)
+		ctx.push_back(input[i].sym);
+	int best = 0, kind = -1, sym = -1;
+	vector<int> seq;
+	for (auto c : repair_syms) {
+		seq.assign(1, c);
+		seq.insert(seq.end(), ctx.begin(), ctx.end());
+		int got = try_repair(seq) - 1;
+		if (got > best) {
+			best = got; kind = MISSING_SYMBOL; sym = c;
+		}
+	}
+	if (bad.sym != g.sid["$"]) {
+		seq.assign(ctx.begin() + 1, ctx.end());
+		int got = 1 + try_repair(seq);
+		if (got > best) {
+			best = got; kind = EXTRA_SYMBOL;
+		}
+		for (auto c : repair_syms) {
+			if (c == bad.sym)
+				continue;
+			seq.assign(1, c);
+			seq.insert(seq.end(), ctx.begin() + 1, ctx.end());
+			got = try_repair(seq);
+			if (got > best) {
+				best = got; kind = REPLACED_SYMBOL; sym = c;
+			}
+		}
+	}
+	string name;
+	for (auto& p : g.sid) {
+		if (p.second == sym)
+			name = p.first;
+	}
+	token fix(name, -1, -1, curline);
+	fix.sym = sym;
+	if (kind == MISSING_SYMBOL) {
+		e.add(MISSING_SYMBOL, curline, name);
+		input.push_front(fix);
+	}
+	else if (kind == EXTRA_SYMBOL) {
+		e.add(EXTRA_SYMBOL, bad.line_num, bad.str);
+		input.pop_front();
+	}
+	else if (kind == REPLACED_SYMBOL) {
+		e.add(REPLACED_SYMBOL, bad.line_num, "\"" + bad.str + "\" should be \"" + name + "\"");
+		fix.line_num = bad.line_num;
+		input.front() = fix;
+	}
+	else {
+		e.add(EARLY_EOF, curline);
+		return false;
+	}
+	return true;
+}
+/**
+ * չʾ﷨Ľ.
+ *
+ */
+void LRparser::show() {
+	e.report();
+	output.push_back("program");
+	string s = "";
+	cout << "program ";
+	for (int i = op.size() - 1; i >= 0; i--) {
+		//cout<<op[i]<<endl;
+		output.pop_back();
+		int num = op[i].num;
+		for (int j = 1; j < g.productions[num].size(); j++)
+			output.push_back(g.productions[num][j]);
 		while (!output.empty()) {
 			if (!g.term.count(output.back()))
 				break;
@@ -737,104 +2479,685 @@ void LRparser::show() {
 	}
 }
 /**
- * ﷨Ƶ룬Bottom-up﷨Ƶ룬
- * ضreductionִض.
- * 
+ * ﷨ֽ.
+ *
+ * \return
  */
-void LRparser::translate() {
-	vector<string> ids;
-	double curvalue = 0,opvalue=0;
-	bool holding = false;
-	int if_true = 0;
-	string compare_op;
-	for (int i = 0; i < exprs.size();i++) {
-		//cout << exprs[i].op<<' '<<curvalue<<' '<<opvalue<<' '<<holding<< endl;
-		vector<token> t = exprs[i].tokens;
-		/*for (int i=t.size()-1;i>=0;i--)
-			cout << t[i].str << ' ';
-		cout << endl;*/
-		///䣬idsмʶnameͣ趨ʼֵtype
-		if (rtype[exprs[i].op.num] == DECLARE) {
-			int type1;
-			if (t[t.size() - 1].str == "int")
-				type1 = INT;
-			else
-				type1 = REAL;
-			ids.push_back(t[t.size() - 2].name);
-			id_type.insert(pair<string, int>(t[t.size() - 2].name, type1));
-			id_value.insert(pair<string, double>(t[t.size() - 2].name, t[t.size() - 4].value));
-		}
-		///߱ʶӦֵֵǰﾳ
-		else if (rtype[exprs[i].op.num] == INSTANT) {
-			if (!holding)
-				curvalue = t[t.size() - 1].value;
-			else {
-				opvalue = t[t.size() - 1].value;
+bytecode LRparser::compile() {
+	bytecode p = build_ir().assemble();
+	p.max_iters = max_iterations;
+	return p;
+}
+/**
+ * ﷨Żм.
+ * resolveÿʶ󶨵λλǱֵţֲٰ֮ң
+ * typecheckȷÿʽͣfoldʽַ벢Ż.
+ *
+ * \return
+ */
+IRProgram LRparser::build_ir() {
+	IRProgram ir;
+	scopes.clear();
+	ids.clear();
+	fdiv_zero.clear();
+	resolve(root, ir);
+	typecheck(root, ir);
+	fold(root, ir);
+	ir.start();
+	cur = 0;
+	gen_stmt(root, ir);
+	ir.blocks[cur].br = tac(I_HALT, -1, -1, -1, -1);
+	ir.optimize();
+	return ir;
+}
+/**
+ * Żм.
+ *
+ */
+void LRparser::show_ir() {
+	if (root != -1 && !repaired)
+		build_ir().show(cout);
+}
+/**
+ * ֽÿһ򣬿ڵסͬ.
+ * ÿֵһµĲλıǰ棬ֱֵӷŽinit
+ * ͬһظʱõһε.
+ *
+ * \param n
+ * \param p
+ */
+void LRparser::resolve(int n, IRProgram& p) {
+	if (n == -1)
+		return;
+	ast_node& x = tree[n];
+	switch (x.kind) {
+	case AST_BLOCK:
+		scopes.push_back(map<string, int>());
+		for (int d = x.b; d != -1; d = tree[d].next) {
+			ast_node& y = tree[d];
+			if (scopes.size() == 1)
+				ids.push_back(y.name);
+			if (scopes.back().count(y.name)) {
+				y.slot = -1;
+				continue;
 			}
-			holding = true;
+			y.slot = scopes.back()[y.name] = p.names.size();
+			p.names.push_back(y.name);
+			p.types.push_back(y.type);
+			p.init.push_back(reg());
+			if (scopes.size() == 1 && y.type == INT)
+				p.init.back().i = real_to_int(y.value);
+			if (scopes.size() == 1 && y.type == REAL)
+				p.init.back().f = y.value;
 		}
-		else if (rtype[exprs[i].op.num] == IDVALUE) {
-			if (id_value.find(t[t.size() - 1].name) == id_value.end())
-				e.add(UNDECLARED_ID, t[t.size() - 1].line_num);
-			if (!holding)
-				curvalue = id_value[t[t.size() - 1].name];
-			else {
-				opvalue = id_value[t[t.size() - 1].name];
-			}
-			holding = true;
-		}
-		///Ǹֵ䣬ﾳеֵĿʶﾳеֵ
-		else if (rtype[exprs[i].op.num] == ASSIGN) {
-			if (id_value.find(t[t.size() - 1].name) == id_value.end())
-				e.add(UNDECLARED_ID_ASSIGN, t[t.size() - 1].line_num);
-			if (if_true != -1) {
-				id_value[t[t.size() - 1].name] = curvalue;
-				holding = false;
-			}
-			if (if_true == 1)
-				if_true = -1;
-			else if (if_true == -1)
-				if_true = 0;
-			curvalue = 0; opvalue = 0; holding = false;
-		}
-		///ﾳеֵдҴﾳ
-		else if (rtype[exprs[i].op.num] == ARITHPRIME) {
-			switch (t[3].str[0]) {
-			case '+':
-				curvalue += opvalue;
-				break;
-			case '-':
-				curvalue -= opvalue;
-				break;
-			case '*':
-				curvalue *= opvalue;
-				break;
-			case '/':
-				if (opvalue == 0)
-					e.add(DIVIDE_BY_ZERO, t[3].line_num);
-				curvalue /= opvalue;
-				break;
+		if (n == root)
+			p.ndecl = p.names.size();
+		for (int s = x.a; s != -1; s = tree[s].next)
+			resolve(s, p);
+		scopes.pop_back();
+		break;
+	case AST_ASSIGN:
+		resolve(x.a, p);
+		x.slot = bind(n, p, UNDECLARED_ID_ASSIGN);
+		break;
+	case AST_ID:
+		x.slot = bind(n, p, UNDECLARED_ID);
+		break;
+	case AST_IF:
+	case AST_WHILE:
+		resolve(x.a, p);
+		resolve(x.b, p);
+		resolve(x.c, p);
+		break;
+	case AST_BINOP:
+		resolve(x.a, p);
+		resolve(x.b, p);
+		break;
+	}
+}
+/**
+ * ڵұʶҲʱetype
+ * һֵΪ0Ĳλͬʶ֮ٱ.
+ *
+ * \param n
+ * \param p
+ * \param etype
+ * \return
+ */
+int LRparser::bind(int n, IRProgram& p, int etype) {
+	const string& name = tree[n].name;
+	for (int i = scopes.size() - 1; i >= 0; i--) {
+		auto it = scopes[i].find(name);
+		if (it != scopes[i].end())
+			return it->second;
+	}
+	e.add(etype, tree[n].line_num);
+	int s = scopes[0][name] = p.names.size();
+	p.names.push_back(name);
+	p.types.push_back(INT);
+	p.init.push_back(reg());
+	return s;
+}
+/**
+ * ͼ飬ȷÿʽintreal.
+ * ߶intintrealȽϽtypeǱȽʱʹõ.
+ * realֱӸĳʵintʱת
+ * realֵܸint͸ֵʱᱨREAL_TO_INT.
+ *
+ * \param n
+ * \param p
+ */
+void LRparser::typecheck(int n, IRProgram& p) {
+	if (n == -1)
+		return;
+	ast_node& x = tree[n];
+	switch (x.kind) {
+	case AST_BLOCK:
+		for (int d = x.b; d != -1; d = tree[d].next) {
+			if (tree[d].type == INT && type_of(tree[d].a) == REAL)
+				e.add(REAL_TO_INT, tree[d].line_num);
+			if (tree[d].type == REAL)
+				promote(tree[d].a);
+		}
+		for (int s = x.a; s != -1; s = tree[s].next)
+			typecheck(s, p);
+		break;
+	case AST_ASSIGN:
+		typecheck(x.a, p);
+		if (p.types[x.slot] == INT && type_of(x.a) == REAL)
+			e.add(REAL_TO_INT, x.line_num);
+		if (p.types[x.slot] == REAL)
+			promote(x.a);
+		break;
+	case AST_IF:
+	case AST_WHILE:
+		typecheck(x.a, p);
+		typecheck(x.b, p);
+		typecheck(x.c, p);
+		break;
+	case AST_BINOP:
+		typecheck(x.a, p);
+		typecheck(x.b, p);
+		x.type = type_of(x.a) == REAL || type_of(x.b) == REAL ? REAL : INT;
+		if (x.type == REAL) {
+			promote(x.a);
+			promote(x.b);
+		}
+		break;
+	case AST_ID:
+		x.type = p.types[x.slot];
+		break;
+	}
+}
+/**
+ * ȱʧıʽint.
+ *
+ * \param n
+ * \return
+ */
+int LRparser::type_of(int n) {
+	return n == -1 ? INT : tree[n].type;
+}
+
+void LRparser::promote(int n) {
+	if (n != -1 && tree[n].kind == AST_LITERAL)
+		tree[n].type = REAL;
+}
+/**
+ * ۵ʹtypecheck֮УѾȷ.
+ * ߶ǳֱʱĹ㣬ơȡ
+ * ȥx+0x-0x*1x/1intx*0ֱӵõ0.
+ * realֻıĻx+0xΪ-0ʱ+0Բ.
+ * ػĽ㣬ԭ.
+ *
+ * \param n
+ * \param p
+ * \return
+ */
+int LRparser::fold(int n, IRProgram& p) {
+	if (n == -1)
+		return n;
+	ast_node& x = tree[n];
+	switch (x.kind) {
+	case AST_BLOCK:
+		for (int s = x.a; s != -1; s = tree[s].next)
+			fold(s, p);
+		break;
+	case AST_ASSIGN:
+		x.a = fold(x.a, p);
+		if (p.types[x.slot] == REAL)
+			promote(x.a);
+		break;
+	case AST_IF:
+	case AST_WHILE:
+		x.a = fold(x.a, p);
+		x.b = fold(x.b, p);
+		x.c = fold(x.c, p);
+		break;
+	case AST_BINOP:
+		x.a = fold(x.a, p);
+		x.b = fold(x.b, p);
+		if (x.type == REAL) {
+			promote(x.a);
+			promote(x.b);
+		}
+		if (x.op < OP_LT)
+			return simplify(n);
+		break;
+	}
+	return n;
+}
+/**
+ * һ㣬Ѿ.
+ * ǳ0ʱڱڱDIVIDE_BY_ZERO.intI_IDIVһ0ûбĳʱɳ0
+ * ĳɳ0ճִУĳʱȻ飬ͬһᱨΣ
+ * realĽinfNaN0Ҳһ0ԲI_FDIVʱ.
+ *
+ * \param n
+ * \return
+ */
+int LRparser::simplify(int n) {
+	ast_node& x = tree[n];
+	int a = x.a, b = x.b;
+	if (x.op == OP_DIV && is_value(b, 0)) {
+		e.add(DIVIDE_BY_ZERO, x.line_num);
+		if (x.type != INT) {
+			fdiv_zero.push_back(x.line_num);
+			return n;
+		}
+		if (pure(a))
+			return make_const(n, 0, 0);
+		x.op = OP_MUL;
+		return n;
+	}
+	if (is_const(a) && is_const(b)) {
+		const ast_node& l = tree[a];
+		const ast_node& r = tree[b];
+		if (x.type == INT) {
+			unsigned long long u = l.ival, v = r.ival;
+			switch (x.op) {
+			case OP_ADD:
+				return make_const(n, (long long)(u + v), 0);
+			case OP_SUB:
+				return make_const(n, (long long)(u - v), 0);
+			case OP_MUL:
+				return make_const(n, (long long)(u * v), 0);
+			case OP_DIV:
+				return make_const(n, r.ival == -1 ? (long long)(0ULL - u) : l.ival / r.ival, 0);
 			}
+		}
+		switch (x.op) {
+		case OP_ADD:
+			return make_const(n, 0, l.value + r.value);
+		case OP_SUB:
+			return make_const(n, 0, l.value - r.value);
+		case OP_MUL:
+			return make_const(n, 0, l.value * r.value);
+		case OP_DIV:
+			return make_const(n, 0, l.value / r.value);
+		}
+	}
+	switch (x.op) {
+	case OP_ADD:
+		if (x.type == INT && is_value(a, 0))
+			return b;
+		if (x.type == INT && is_value(b, 0))
+			return a;
+		break;
+	case OP_SUB:
+		if (is_value(b, 0))
+			return a;
+		break;
+	case OP_MUL:
+		if (is_value(a, 1))
+			return b;
+		if (is_value(b, 1))
+			return a;
+		if (x.type == INT && ((is_value(a, 0) && pure(b)) || (is_value(b, 0) && pure(a))))
+			return make_const(n, 0, 0);
+		break;
+	case OP_DIV:
+		if (is_value(b, 1))
+			return a;
+		break;
+	}
+	return n;
+}
+bool LRparser::is_const(int n) {
+	return n != -1 && tree[n].kind == AST_LITERAL;
+}
+/**
+ * nǷֵΪvĳ.
+ *
+ * \param n
+ * \param v
+ * \return
+ */
+bool LRparser::is_value(int n, long long v) {
+	if (!is_const(n))
+		return false;
+	return tree[n].type == INT ? tree[n].ival == v : tree[n].value == v;
+}
+/**
+ * ʽûгȥٱʱĳ0.
+ *
+ * \param n
+ * \return
+ */
+bool LRparser::pure(int n) {
+	if (n == -1 || tree[n].kind != AST_BINOP)
+		return true;
+	return tree[n].op != OP_DIV && pure(tree[n].a) && pure(tree[n].b);
+}
+/**
+ * ѽnĳɳͲ䣬intivrealfv.
+ *
+ * \param n
+ * \param iv
+ * \param fv
+ * \return
+ */
+int LRparser::make_const(int n, long long iv, double fv) {
+	ast_node& x = tree[n];
+	x.kind = AST_LITERAL;
+	x.ival = iv;
+	x.value = x.type == INT ? (double)iv : fv;
+	x.a = x.b = -1;
+	return n;
+}
+/**
+ * м룬ʽֵµʱֵ.
+ * дǰcurifcur֧ϵĿ.
+ *
+ * \param n
+ * \param ir
+ * \return Žֵţ;ǽtype
+ */
+int LRparser::gen_expr(int n, IRProgram& ir) {
+	if (n == -1)
+		return ir.konst(INT, reg());
+	const ast_node& x = tree[n];
+	switch (x.kind) {
+	case AST_LITERAL: {
+		reg v;
+		if (x.type == INT)
+			v.i = x.ival;
+		else
+			v.f = x.value;
+		return ir.konst(x.type, v);
+	}
+	case AST_ID:
+		return x.slot;
+	case AST_BINOP: {
+		int l = gen_as(x.a, x.type, ir);
+		int r = gen_as(x.b, x.type, ir);
+		int t = ir.temp(x.type);
+		emit(ir, (x.type == INT ? I_IADD : I_FADD) + x.op, t, l, r, x.line_num);
+		return t;
+	}
+	}
+	return ir.konst(INT, reg());
+}
+/**
+ * ɱʽתtype.
+ *
+ * \param n
+ * \param type
+ * \param ir
+ * \return
+ */
+int LRparser::gen_as(int n, int type, IRProgram& ir) {
+	int v = gen_expr(n, ir);
+	if (type == REAL && type_of(n) == INT) {
+		int t = ir.temp(REAL);
+		emit(ir, I_ITOF, t, v, -1, n == -1 ? -1 : tree[n].line_num);
+		return t;
+	}
+	return v;
+}
+/**
+ * ΪtypeֵvdͲͬʱڴͬʱת.
+ *
+ * \param d
+ * \param v
+ * \param type
+ * \param ln
+ * \param ir
+ */
+void LRparser::gen_store(int d, int v, int type, int ln, IRProgram& ir) {
+	if (type != ir.types[d])
+		emit(ir, type == INT ? I_ITOF : I_FTOI, d, v, -1, ln);
+	else
+		emit(ir, I_MOVE, d, v, -1, ln);
+}
 
+void LRparser::emit(IRProgram& ir, int op, int d, int x, int y, int ln) {
+	ir.blocks[cur].code.push_back(tac(op, d, x, y, ln));
+}
+/**
+ * жϽǰ飬ʱfallʱtaken.
+ *
+ * \param n
+ * \param ir
+ * \param taken
+ * \param fall
+ */
+void LRparser::gen_cond(int n, IRProgram& ir, int taken, int fall) {
+	int l, r, op = OP_EQ, type = INT;
+	if (n != -1 && tree[n].kind == AST_BINOP && tree[n].op >= OP_LT) {
+		type = tree[n].type;
+		l = gen_as(tree[n].a, type, ir);
+		r = gen_as(tree[n].b, type, ir);
+		op = tree[n].op;
+	}
+	else
+		l = r = ir.konst(INT, reg());
+	basic_block& bb = ir.blocks[cur];
+	bb.br = tac((type == INT ? I_JNILT : I_JNFLT) + op - OP_LT, -1, l, r, n == -1 ? -1 : tree[n].line_num);
+	bb.taken = taken;
+	bb.fall = fall;
+}
+/**
+ * м룬if֧һ飬ϵĿ.
+ *
+ * \param n
+ * \param ir
+ */
+void LRparser::gen_stmt(int n, IRProgram& ir) {
+	if (n == -1)
+		return;
+	const ast_node& x = tree[n];
+	switch (x.kind) {
+	///ֲÿνʱ³ʼıinitоѾź
+	case AST_BLOCK:
+		if (n != root) {
+			for (int d = x.b; d != -1; d = tree[d].next) {
+				if (tree[d].slot != -1)
+					gen_store(tree[d].slot, gen_expr(tree[d].a, ir), type_of(tree[d].a), tree[d].line_num, ir);
+			}
+		}
+		for (int s = x.a; s != -1; s = tree[s].next)
+			gen_stmt(s, ir);
+		break;
+	case AST_ASSIGN:
+		gen_store(x.slot, gen_expr(x.a, ir), type_of(x.a), x.line_num, ir);
+		break;
+	///鰴Դ˳ţelse֧Ŀ齨úٻתĿ
+	case AST_IF: {
+		int head = cur;
+		gen_cond(x.a, ir, -1, ir.new_block());
+		cur = ir.blocks[head].fall;
+		gen_stmt(x.b, ir);
+		int then_end = cur;
+		cur = ir.new_block();
+		ir.blocks[head].taken = cur;
+		gen_stmt(x.c, ir);
+		int join = ir.new_block();
+		for (int b : { then_end, cur }) {
+			ir.blocks[b].br = tac(I_JMP, -1, -1, -1, x.line_num);
+			ir.blocks[b].taken = join;
+		}
+		cur = join;
+		break;
+	}
+	///ѭͷÿζ¼㣻ѭʱI_LOOPѭͷһμһ
+	case AST_WHILE: {
+		int head = ir.new_block();
+		ir.blocks[cur].br = tac(I_JMP, -1, -1, -1, x.line_num);
+		ir.blocks[cur].taken = head;
+		cur = head;
+		gen_cond(x.a, ir, -1, ir.new_block());
+		cur = ir.blocks[head].fall;
+		gen_stmt(x.b, ir);
+		ir.blocks[cur].br = tac(I_LOOP, -1, -1, -1, x.line_num);
+		ir.blocks[cur].taken = head;
+		cur = ir.new_block();
+		ir.blocks[head].taken = cur;
+		break;
+	}
+	}
+}
+/**
+ * ﷨Ƶ룬execute﷨ֽ룬ִк.
+ * 0ʱ飬ִֻеĳŻᱨѭmax_iterationsʱִֹͣв.
+ * ﷨ʱֻ﷨󣬲ִ.
+ *
+ */
+void LRparser::translate() {
+	if (root != -1 && !repaired) {
+		vector<error> errors;
+		for (auto& v : package(false).run(map<string, typed_value>(), &errors))
+			id_value[v.first] = v.second;
+		///ʱrealԳ0ڱѾ
+		for (auto& x : errors) {
+			if (x.type != DIVIDE_BY_ZERO || find(fdiv_zero.begin(), fdiv_zero.end(), x.line_num) == fdiv_zero.end())
+				e.add(x.type, x.line_num);
+		}
+	}
+	print_values();
+}
+/**
+ * 뵱ǰ﷨ͬͺѾֵĴһ.
+ * ִֻһεֱߴ뷭ɱ벢㣬Ҫִлߺѭʱŷ.
+ *
+ * \param hot Ƿִᷴ
+ * \return
+ */
+PreparedProgram LRparser::package(bool hot) {
+	PreparedProgram h;
+	if (root != -1 && !repaired) {
+		h.prog = make_shared<const bytecode>(compile());
+		bool loops = any_of(h.prog->code.begin(), h.prog->code.end(), [](const insn& x) { return x.op == I_LOOP; });
+		if (use_jit && (hot || loops)) {
+			auto nc = make_shared<NativeCode>();
+			if (nc->compile(*h.prog))
+				h.native = nc;
+		}
+	}
+	h.e = e;
+	return h;
+}
+/**
+ * һԴ򣬵õԷִеPreparedProgram.
+ * ֻinit_tableʱһΣͬһLRparserprepare
+ * ÿζӿյ״̬ʼ.
+ *
+ * \param input_string
+ * \return
+ */
+PreparedProgram LRparser::prepare(string input_string) {
+	input.clear(); work.clear(); state.clear(); op.clear();
+	e = ErrorHandler();
+	id_value.clear(); ids.clear();
+	tree.clear(); root = -1;
+	repaired = false;
+	execute(input_string);
+	return package(true);
+}
+/**
+ * Լʱִе嶯worknԪǲʽҲ򣩣
+ * ﷨дres.astresҲѹwork.
+ *
+ * \param pid ʽid
+ * \param n ҲȥEĳ
+ * \param res ʽ󲿶ӦջԪ
+ */
+void LRparser::action(int pid, int n, token& res) {
+	///rhs(i)Ҳi
+	auto rhs = [&](int i) -> token& { return work[n - 1 - i]; };
+	switch (rtype[pid]) {
+	///䣬resolveʱż
+	case DECLARE:
+		res.ast = new_node(AST_DECL, rhs(1).line_num);
+		tree[res.ast].name = rhs(1).name;
+		tree[res.ast].type = rhs(0).str == "int" ? INT : REAL;
+		tree[res.ast].a = rhs(3).ast;
+		if (rhs(3).ast != -1)
+			tree[res.ast].value = tree[rhs(3).ast].value;
+		break;
+	case INSTANT: {
+		res.ast = new_node(AST_LITERAL, rhs(0).line_num);
+		tree[res.ast].value = rhs(0).value;
+		tree[res.ast].ival = real_to_int(rhs(0).value);
+		tree[res.ast].type = rhs(0).str == "INTNUM" ? INT : REAL;
+		break;
+	}
+	case IDVALUE:
+		res.ast = new_node(AST_ID, rhs(0).line_num);
+		tree[res.ast].name = rhs(0).name;
+		break;
+	///primeҵݹģҪϵϵĲջ
+	///βĿղʽҵͷprimeֻҪѽϴ
+	case FOLD: {
+		const string& ops = fold_ops[pid];
+		int k = 0;
+		while (k + 2 < work.size() && work[k + 1].str.size() == 1 && ops.find(work[k + 1].str[0]) != string::npos)
+			k += 2;
+		int t = work[k].ast;
+		for (; k > 0; k -= 2) {
+			const token& o = work[k - 1];
+			int b = new_node(AST_BINOP, o.line_num);
+			tree[b].op = string("+-*/").find(o.str[0]);
+			tree[b].a = t;
+			tree[b].b = work[k - 2].ast;
+			t = b;
+		}
+		res.ast = t;
+		break;
+	}
+	case ARITHPRIME:
+		res.ast = rhs(2).ast;
+		break;
+	///arithexprmultexprűʽĽ㶼Ҳڶ
+	case ARITH:
+		res.ast = rhs(1).ast;
+		break;
+	case BOOLOP:
+		res.name = rhs(0).str;
+		res.line_num = rhs(0).line_num;
+		break;
+	case BOOL: {
+		static const char* cmp[] = { "<", ">", "<=", ">=", "==" };
+		res.ast = new_node(AST_BINOP, rhs(1).line_num);
+		tree[res.ast].op = OP_EQ;
+		for (int i = 0; i < 5; i++) {
+			if (rhs(1).name == cmp[i])
+				tree[res.ast].op = OP_LT + i;
 		}
-		else if (rtype[exprs[i].op.num] == BOOLOP)
-			compare_op=t[1].str;
-		else if (rtype[exprs[i].op.num] == BOOL) {
-			if (compare_op == "<=")
-				if_true = (curvalue <= opvalue) ? 1 : -1;
-			else if (compare_op == ">=")
-				if_true = (curvalue >= opvalue) ? 1 : -1;
-			else if (compare_op == ">")
-				if_true = (curvalue > opvalue) ? 1 : -1;
-			else if (compare_op == "<")
-				if_true = (curvalue < opvalue) ? 1 : -1;
-			else if (compare_op == "==")
-				if_true = (curvalue == opvalue) ? 1 : -1;
-			curvalue = 0; opvalue = 0;
-			holding = false;
-		}
-	}
-	///ӡ﷨ƵĽ
+		tree[res.ast].a = rhs(0).ast;
+		tree[res.ast].b = rhs(2).ast;
+		break;
+	}
+	case IF:
+		res.ast = new_node(AST_IF, rhs(0).line_num);
+		tree[res.ast].a = rhs(2).ast;
+		tree[res.ast].b = rhs(5).ast;
+		tree[res.ast].c = rhs(7).ast;
+		break;
+	case WHILE:
+		res.ast = new_node(AST_WHILE, rhs(0).line_num);
+		tree[res.ast].a = rhs(2).ast;
+		tree[res.ast].b = rhs(4).ast;
+		break;
+	case ASSIGN:
+		res.ast = new_node(AST_ASSIGN, rhs(0).line_num);
+		tree[res.ast].name = rhs(0).name;
+		tree[res.ast].a = rhs(2).ast;
+		break;
+	case PASS:
+		res.ast = rhs(0).ast;
+		break;
+	///кnext
+	case STMTS:
+		res.ast = rhs(0).ast;
+		if (res.ast == -1)
+			res.ast = rhs(n - 1).ast;
+		else
+			tree[res.ast].next = rhs(n - 1).ast;
+		break;
+	case BLOCK:
+		res.ast = new_node(AST_BLOCK, rhs(0).line_num);
+		tree[res.ast].b = rhs(1).ast;
+		tree[res.ast].a = rhs(2).ast;
+		break;
+	///compoundstmt
+	case PROGRAM:
+		root = new_node(AST_BLOCK, 1);
+		tree[root].b = rhs(0).ast;
+		tree[root].a = rhs(1).ast;
+		break;
+	}
+}
+
+int LRparser::new_node(int kind, int ln) {
+	tree.push_back(ast_node(kind, ln));
+	return tree.size() - 1;
+}
+/**
+ * ӡ﷨ƵĽ.
+ *
+ */
+void LRparser::print_values() {
 	if (!e.report()) {
 		for (auto id : ids) {
 			cout << id << ": " << id_value[id] << endl;
@@ -842,6 +3165,28 @@ void LRparser::translate() {
 	}
 }
 
+/**
+ * ˮģʽʷ﷨ͬʱɷ룩׶ͬʱУ
+ * ʷڵ߳ϣ﷨ڵ߳ϣ
+ * ׶֮RingBufferbatchݣڴֻdepth*batchйأ
+ * ִУexecutetranslateͬ.
+ *
+ * \param input_string
+ * \param batch
+ * \param depth
+ */
+void LRparser::execute_pipelined(string input_string, int batch, int depth) {
+	RingBuffer<vector<token>> tokq(depth);
+	LexAnalyzer lex(g);
+	lex.sink = &tokq;
+	lex.batch = batch;
+	record_op = false;
+	thread lexer([&]() { lex.execute(input_string); });
+	parse(&tokq);
+	lexer.join();
+	translate();
+}
+
 void Analysis()
 {
 	string prog;
@@ -853,12 +3198,12 @@ void Analysis()
 program -> decls compoundstmt
 decls -> decl ; decls
 decls -> E
-decl -> int ID = INTNUM
-decl -> real ID = REALNUM
+decl -> int ID = number
+decl -> real ID = number
 stmt -> ifstmt
 stmt -> assgstmt
 stmt -> compoundstmt
-compoundstmt -> { stmts }
+compoundstmt -> { decls stmts }
 stmts -> stmt stmts
 stmts -> E
 ifstmt -> if ( boolexpr ) then stmt else stmt
@@ -880,7 +3225,11 @@ multexprprime -> E
 simpleexpr -> ID
 simpleexpr -> INTNUM
 simpleexpr -> REALNUM
-simpleexpr -> ( arithexpr ))");
+simpleexpr -> ( arithexpr )
+number -> INTNUM
+number -> REALNUM
+stmt -> whilestmt
+whilestmt -> while ( boolexpr ) stmt)");
 	lrp.execute(prog);
 	lrp.translate();
 	/********* End *********/